@@ -0,0 +1,27 @@
+#!/bin/sh
+# batch throughput
+# ================
+# echoes N generated forms (default 10^6) through `clisp --batch` over a pipe
+#
+# usage: [CLISP=./clisp] [CLISPFLAGS=...] bench/batch.sh [N]
+
+set -e
+
+N=${1:-1000000}
+CLISP=${CLISP:-./clisp}
+CLISPFLAGS=${CLISPFLAGS:-}
+INPUT=$(mktemp)
+trap 'rm -f "$INPUT"' EXIT
+
+awk -v n="$N" 'BEGIN {
+    for (i = 0; i < n; ++i)
+        printf "(form %d [%d.5 \"s\"] (nil true))\n", i, i
+}' > "$INPUT"
+
+start=$(date +%s%N)
+cat "$INPUT" | "$CLISP" --batch $CLISPFLAGS > /dev/null
+end=$(date +%s%N)
+
+awk -v n="$N" -v ns=$((end - start)) 'BEGIN {
+    printf "batch: %d forms in %.3f s (%.0f forms/s)\n", n, ns / 1e9, n / (ns / 1e9)
+}'
@@ -0,0 +1,93 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "map.h"
+#include "node.h"
+
+#define KEYS 1000000
+
+static struct node *longs, *symbols;
+
+static void
+insert(void *arg)
+{
+    struct node *keys = arg;
+    struct map m;
+    size_t ind;
+    map_init(&m);
+    for (ind = 0; ind < KEYS; ++ind)
+        map_put(&m, &keys[ind], &keys[ind]);
+    map_free(&m);
+}
+
+static struct map filled;
+
+static void
+lookup_hit(void *arg)
+{
+    struct node *keys = arg;
+    size_t ind;
+    for (ind = 0; ind < KEYS; ++ind)
+        if (!map_get(&filled, &keys[ind]))
+            abort();
+}
+
+static void
+lookup_miss(void *arg)
+{
+    struct node key;
+    size_t ind;
+    (void)arg;
+    node_init(&key);
+    for (ind = 0; ind < KEYS; ++ind) {
+        node_set(&key, T_LONG, (union node_data){ .l = -1 - (long)ind });
+        if (map_get(&filled, &key))
+            abort();
+    }
+}
+
+static void
+fill(struct node *keys)
+{
+    size_t ind;
+    map_free(&filled);
+    map_init(&filled);
+    for (ind = 0; ind < KEYS; ++ind)
+        map_put(&filled, &keys[ind], &keys[ind]);
+}
+
+int
+main(int argc, char *argv[])
+{
+    char name[32];
+    size_t ind;
+    bench_init(argc, argv);
+    longs = malloc(KEYS * sizeof(struct node));
+    symbols = malloc(KEYS * sizeof(struct node));
+    for (ind = 0; ind < KEYS; ++ind) {
+        node_init(&longs[ind]);
+        /* spread out, as ids from another system would be */
+        node_set(&longs[ind], T_LONG, (union node_data){ .l = ind * 2654435761ul % 4294967291ul });
+        snprintf(name, sizeof(name), "key-%zu", ind);
+        node_init(&symbols[ind]);
+        node_set(&symbols[ind], T_EXPR, (union node_data){ .s = malloc(strlen(name) + 1) });
+        strcpy(symbols[ind].data.s, name);
+    }
+    map_init(&filled);
+    bench_run("map/insert_1e6_longs", insert, longs);
+    fill(longs);
+    bench_run("map/lookup_hit_1e6_longs", lookup_hit, longs);
+    bench_run("map/lookup_miss_1e6_longs", lookup_miss, NULL);
+    bench_run("map/insert_1e6_symbols", insert, symbols);
+    fill(symbols);
+    bench_run("map/lookup_hit_1e6_symbols", lookup_hit, symbols);
+    map_free(&filled);
+    for (ind = 0; ind < KEYS; ++ind)
+        free(symbols[ind].data.s);
+    free(symbols);
+    free(longs);
+    return 0;
+}
@@ -0,0 +1,88 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "harness.h"
+#include "node.h"
+#include "vector.h"
+
+/* tokenize runs furl itself, so this covers lexing plus tree building */
+static void
+read_lines(void *arg)
+{
+    struct vector *lines = arg, forest;
+    size_t ind, endind;
+    vector_init(&forest, sizeof(struct vector));
+    for (ind = 0, endind = vector_size(lines); ind < endind; ++ind) {
+        tokenize(*(char **)vector_get(lines, ind), &forest);
+        dropForest(&forest);
+    }
+    vector_free(&forest);
+}
+
+/* token stream of nested lists, handed to furl alone */
+static void
+build_tree(void *arg)
+{
+    struct vector *tokens = arg, forest;
+    vector_init(&forest, sizeof(struct vector));
+    furl(&forest, tokens);
+    dropForest(&forest);
+    vector_free(&forest);
+}
+
+static void
+print_forest(void *arg)
+{
+    struct vector *forest = arg;
+    size_t ind, endind;
+    for (ind = 0, endind = vector_size(forest); ind < endind; ++ind)
+        PRINT(vector_get(forest, ind));
+}
+
+static void
+make_tokens(struct vector *tokens)
+{
+    struct node node;
+    size_t ind;
+    vector_init(tokens, sizeof(struct node));
+    node_init(&node);
+    for (ind = 0; ind < 20000; ++ind) {
+        switch (ind % 5) {
+            case 0: node_set(&node, T_LIST, (union node_data){ .c = '(' }); break;
+            case 4: node_set(&node, T_LIST, (union node_data){ .c = ')' }); break;
+            default: node_set(&node, T_INT, (union node_data){ .i = ind });
+        }
+        vector_push(tokens, &node);
+    }
+}
+
+int
+main(int argc, char *argv[])
+{
+    char name[64];
+    enum corpus corpus;
+    struct vector lines, tokens, forest;
+    size_t ind, endind;
+    bench_init(argc, argv);
+    if (!freopen("/dev/null", "w", stdout))
+        return 1;
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    for (corpus = 0; corpus < CORPORA; ++corpus) {
+        corpus_lines(corpus, &lines);
+        snprintf(name, sizeof(name), "tokenize/%s", corpus_name(corpus));
+        bench_run(name, read_lines, &lines);
+        vector_init(&forest, sizeof(struct vector));
+        for (ind = 0, endind = vector_size(&lines); ind < endind; ++ind)
+            tokenize(*(char **)vector_get(&lines, ind), &forest);
+        snprintf(name, sizeof(name), "print/%s", corpus_name(corpus));
+        bench_run(name, print_forest, &forest);
+        dropForest(&forest);
+        vector_free(&forest);
+        corpus_free(&lines);
+    }
+    make_tokens(&tokens);
+    bench_run("furl/flat_lists", build_tree, &tokens);
+    vector_free(&tokens);
+    return 0;
+}
@@ -0,0 +1,92 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "vector.h"
+
+/* one form of about 100k tokens typed a few tokens per line */
+#define REPL_LINES 20000
+
+static char *
+make_line(size_t ind)
+{
+    char *line = malloc(32);
+    if (ind == 0)
+        snprintf(line, 32, "(do");
+    else if (ind == REPL_LINES - 1)
+        snprintf(line, 32, ")");
+    else if (ind % 50 == 1)
+        snprintf(line, 32, "  \"s%zu", ind); /* string left open */
+    else if (ind % 50 == 2)
+        snprintf(line, 32, "  %zu\"", ind);
+    else
+        snprintf(line, 32, "  (f %zu x)", ind);
+    return line;
+}
+
+/* time every line of the form through the incremental reader */
+static void
+read_incremental(struct vector *lines, double *samples)
+{
+    struct readstate state;
+    struct vector forest;
+    size_t ind, endind;
+    double start;
+    readInit(&state);
+    vector_init(&forest, sizeof(struct vector));
+    for (ind = 0, endind = vector_size(lines); ind < endind; ++ind) {
+        start = bench_now();
+        readLine(&state, *(char **)vector_get(lines, ind), &forest);
+        if (samples)
+            samples[ind] = bench_now() - start;
+    }
+    dropForest(&forest);
+    vector_free(&forest);
+    readFree(&state);
+}
+
+/* what every line costs a reader that starts over on the whole buffer */
+static void
+read_whole(void *arg)
+{
+    struct vector forest;
+    vector_init(&forest, sizeof(struct vector));
+    tokenize(arg, &forest);
+    dropForest(&forest);
+    vector_free(&forest);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct vector lines;
+    size_t ind, len = 0;
+    double *samples;
+    char *line, *whole;
+    bench_init(argc, argv);
+    vector_init(&lines, sizeof(char *));
+    for (ind = 0; ind < REPL_LINES; ++ind) {
+        line = make_line(ind);
+        len += strlen(line) + (ind % 50 == 1 ? 2 : 1); /* separator, see below */
+        vector_push(&lines, &line);
+    }
+    whole = malloc(len + 1);
+    for (ind = 0, len = 0; ind < REPL_LINES; ++ind) {
+        line = *(char **)vector_get(&lines, ind);
+        len += sprintf(whole + len, "%s%s", line,
+                (ind % 50 == 1) ? "\\n" : " "); /* the same string, one line */
+    }
+    samples = malloc(REPL_LINES * sizeof(double));
+    read_incremental(&lines, NULL); /* warm up */
+    read_incremental(&lines, samples);
+    bench_report("repl/line_incremental", samples, REPL_LINES);
+    bench_run("repl/line_reparse_all", read_whole, whole);
+    free(samples);
+    free(whole);
+    for (ind = 0; ind < REPL_LINES; ++ind)
+        free(*(char **)vector_get(&lines, ind));
+    vector_free(&lines);
+    return 0;
+}
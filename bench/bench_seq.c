@@ -0,0 +1,57 @@
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "harness.h"
+#include "seq.h"
+
+/* (rec N ...) -> N */
+static void
+record_id(struct node *form, struct node *out, void *ctx)
+{
+    struct node *id = form->data.n->child ? form->data.n->child->sibling : NULL;
+    node_set(out, T_LONG, (union node_data){ .l = id && id->type == T_INT ? id->data.i : 0 });
+}
+
+static int
+odd(struct node *item, void *ctx)
+{
+    return item->data.l % 2;
+}
+
+static void
+sum(struct node *acc, struct node *item, void *ctx)
+{
+    acc->data.l += item->data.l;
+}
+
+/* streams every form of FILE through map, filter and reduce and reports the
+ * peak RSS, which stays flat however large FILE is */
+int
+main(int argc, char *argv[])
+{
+    int fd;
+    size_t count;
+    double start;
+    struct reader reader;
+    struct node acc;
+    struct rusage usage;
+    if (argc != 2 || (fd = open(argv[1], O_RDONLY)) < 0) {
+        fprintf(stderr, "usage: %s FILE\n", argv[0]);
+        return 2;
+    }
+    reader_init(&reader, fd);
+    node_set(&acc, T_LONG, (union node_data){ .l = 0 });
+    start = bench_now();
+    count = seq_reduce(seq_filter(seq_map(formSeq(&reader), record_id, NULL), odd, NULL),
+            sum, &acc, NULL);
+    getrusage(RUSAGE_SELF, &usage);
+    printf("stream: %zu odd records of %s, sum %ld, %.3f s, max rss %ld KiB\n",
+            count, argv[1], acc.data.l, (bench_now() - start) / 1e9, usage.ru_maxrss);
+    reader_free(&reader);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,63 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "harness.h"
+#include "vector.h"
+
+#define PUSHES  100000
+#define INSERTS 5000
+
+static void
+push_pop(void *arg)
+{
+    struct vector v;
+    long ind;
+    (void)arg;
+    vector_init(&v, sizeof(long));
+    for (ind = 0; ind < PUSHES; ++ind)
+        vector_push(&v, &ind);
+    while (vector_size(&v))
+        vector_pop(&v, &ind);
+    vector_free(&v);
+}
+
+static void
+push_get(void *arg)
+{
+    struct vector v;
+    long ind, sum = 0;
+    (void)arg;
+    vector_init(&v, sizeof(long));
+    for (ind = 0; ind < PUSHES; ++ind)
+        vector_push(&v, &ind);
+    for (ind = 0; ind < PUSHES; ++ind)
+        sum += *(long *)vector_get(&v, ind);
+    if (sum != (long)PUSHES * (PUSHES - 1) / 2)
+        abort();
+    vector_free(&v);
+}
+
+static void
+insert_remove_front(void *arg)
+{
+    struct vector v;
+    long ind;
+    (void)arg;
+    vector_init(&v, sizeof(long));
+    for (ind = 0; ind < INSERTS; ++ind)
+        vector_insert(&v, 0, &ind);
+    while (vector_size(&v))
+        vector_remove(&v, 0, &ind);
+    vector_free(&v);
+}
+
+int
+main(int argc, char *argv[])
+{
+    bench_init(argc, argv);
+    bench_run("vector/push_pop", push_pop, NULL);
+    bench_run("vector/push_get", push_get, NULL);
+    bench_run("vector/insert_remove_front", insert_remove_front, NULL);
+    return 0;
+}
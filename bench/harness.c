@@ -0,0 +1,177 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "harness.h"
+
+static int json = 0;
+static size_t reps = BENCH_REPS;
+
+static const char *corpus_names[CORPORA] = {
+    "deep", "wide", "numbers", "strings", "symbols"
+};
+
+void
+bench_init(int argc, char *argv[])
+{
+    int ind;
+    for (ind = 1; ind < argc; ++ind) {
+        if (strcmp(argv[ind], "--json") == 0) {
+            json = 1;
+        } else if (strncmp(argv[ind], "--reps=", 7) == 0 && atoi(argv[ind] + 7) > 0) {
+            reps = atoi(argv[ind] + 7);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--reps=N]\n", argv[0]);
+            exit(2);
+        }
+    }
+    if (!json)
+        fprintf(stderr, "%-28s %14s %14s %4s %6s\n", "benchmark", "median ns", "tail ns", "", "reps");
+}
+
+double
+bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int
+cmpdouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* results go to stderr so that drivers may send PRINT output to /dev/null;
+ * sorts samples in place. Below 100 samples the 99th percentile is just the
+ * slowest sample, so the tail is reported as max rather than p99 */
+void
+bench_report(const char *name, double *samples, size_t count)
+{
+    double median, tail;
+    const char *label = count < 100 ? "max" : "p99";
+    qsort(samples, count, sizeof(double), cmpdouble);
+    median = samples[count / 2];
+    tail = samples[(count * 99 - 1) / 100];
+    if (json)
+        fprintf(stderr, "{\"name\": \"%s\", \"median_ns\": %.0f, \"%s_ns\": %.0f, \"reps\": %zu}\n",
+                name, median, label, tail, count);
+    else
+        fprintf(stderr, "%-28s %14.0f %14.0f %4s %6zu\n", name, median, tail, label, count);
+}
+
+void
+bench_run(const char *name, bench_fn fn, void *arg)
+{
+    size_t ind;
+    double start, *samples;
+    samples = malloc(reps * sizeof(double));
+    for (ind = 0; ind < BENCH_WARMUP; ++ind)
+        fn(arg);
+    for (ind = 0; ind < reps; ++ind) {
+        start = bench_now();
+        fn(arg);
+        samples[ind] = bench_now() - start;
+    }
+    bench_report(name, samples, reps);
+    free(samples);
+}
+
+const char *
+corpus_name(enum corpus corpus)
+{
+    return corpus_names[corpus];
+}
+
+/* xorshift so every run and every machine sees the same corpus */
+static unsigned long
+corpus_rand(void)
+{
+    static unsigned long state = 88172645463325252ul;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static char *
+corpus_line(enum corpus corpus)
+{
+    size_t len = 0, cap = 1 << 14, ind;
+    char *line = malloc(cap);
+    #define EMIT(...) (len += snprintf(line + len, cap - len, __VA_ARGS__))
+    switch (corpus) {
+        case CORPUS_DEEP:
+            for (ind = 0; ind < 200; ++ind)
+                EMIT("(%c ", "abc"[ind % 3]);
+            for (ind = 0; ind < 200; ++ind)
+                EMIT(")");
+            break;
+        case CORPUS_WIDE:
+            EMIT("(");
+            for (ind = 0; ind < 400; ++ind)
+                EMIT(ind % 2 ? " x%zu" : " %zu", ind);
+            EMIT(")");
+            break;
+        case CORPUS_NUMBERS:
+            EMIT("[");
+            for (ind = 0; ind < 200; ++ind) {
+                switch (corpus_rand() % 7) {
+                    case 0: EMIT(" %lu", corpus_rand() % 100000); break;
+                    case 1: EMIT(" -%lul", corpus_rand() % 100000); break;
+                    case 2: EMIT(" %luu", corpus_rand() % 65536); break;
+                    case 3: EMIT(" .%lud", corpus_rand() % 1000); break;
+                    case 4: EMIT(" %lu.%lu", corpus_rand() % 1000, corpus_rand() % 1000); break;
+                    case 5: EMIT(" 0x%lx", corpus_rand() % 65536); break;
+                    case 6: EMIT(" 0o%lo", corpus_rand() % 4096); break;
+                }
+            }
+            EMIT("]");
+            break;
+        case CORPUS_STRINGS:
+            EMIT("(");
+            for (ind = 0; ind < 40; ++ind)
+                EMIT(" \"line %lu\\tcol\\n %zu\"", corpus_rand() % 1000, ind);
+            EMIT(")");
+            break;
+        case CORPUS_SYMBOLS:
+            EMIT("(");
+            for (ind = 0; ind < 200; ++ind) {
+                if (ind % 4)
+                    EMIT(" sym_%lx!", corpus_rand() % 4096);
+                else
+                    EMIT(" <=>");
+            }
+            EMIT(")");
+            break;
+        default:
+            break;
+    }
+    #undef EMIT
+    return line;
+}
+
+void
+corpus_lines(enum corpus corpus, struct vector *lines)
+{
+    size_t ind;
+    char *line;
+    vector_init(lines, sizeof(char *));
+    for (ind = 0; ind < 50; ++ind) {
+        line = corpus_line(corpus);
+        vector_push(lines, &line);
+    }
+}
+
+void
+corpus_free(struct vector *lines)
+{
+    size_t ind, endind;
+    for (ind = 0, endind = vector_size(lines); ind < endind; ++ind)
+        free(*(char **)vector_get(lines, ind));
+    vector_free(lines);
+}
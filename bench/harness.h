@@ -0,0 +1,39 @@
+
+#ifndef BENCH_WARMUP
+#define BENCH_WARMUP 3
+#endif
+
+#ifndef BENCH_REPS
+#define BENCH_REPS 100
+#endif
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdlib.h>
+
+#include "vector.h"
+#include "../lisp.h" /* entry points from lisp.c, built with -DCLISP_NO_MAIN */
+
+enum corpus {
+    CORPUS_DEEP,    /* deeply nested lists */
+    CORPUS_WIDE,    /* flat lists with many elements */
+    CORPUS_NUMBERS, /* ints, longs, hex, octal and doubles */
+    CORPUS_STRINGS, /* string literals with escapes */
+    CORPUS_SYMBOLS, /* symbols and special symbols */
+    CORPORA
+};
+
+typedef void (*bench_fn)(void *);
+
+void bench_init(int, char *[]);
+void bench_run(const char *, bench_fn, void *);
+void bench_report(const char *, double *, size_t);
+double bench_now(void);
+
+const char *corpus_name(enum corpus);
+void corpus_lines(enum corpus, struct vector *);
+void corpus_free(struct vector *);
+
+#endif
+
@@ -0,0 +1,24 @@
+#!/bin/sh
+# streaming reduce
+# ================
+# writes a file of generated records (default 64 MiB) and reduces over all of
+# its forms with bench/bench_seq, first over an eighth of it and then over all
+# of it, so that the two peak RSS figures can be compared
+#
+# usage: [TMPDIR=...] bench/stream.sh [MiB]    e.g. bench/stream.sh 10240
+
+set -e
+
+MIB=${1:-64}
+INPUT=$(mktemp)
+trap 'rm -f "$INPUT" "$INPUT.part"' EXIT
+
+# each record is 64 bytes
+awk -v n=$((MIB * 16384)) 'BEGIN {
+    for (i = 0; i < n; ++i)
+        printf "(rec %10d [%10d.5 \"%-14s\"] {k %10d})\n", i, i, "x", i % 7
+}' > "$INPUT"
+
+head -n $((MIB * 2048)) "$INPUT" > "$INPUT.part"
+bench/bench_seq "$INPUT.part"
+bench/bench_seq "$INPUT"
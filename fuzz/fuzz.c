@@ -0,0 +1,15 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz.h"
+
+/* the reader works on NUL-terminated lines, fuzzer input is raw bytes */
+char *
+fuzz_string(const uint8_t *data, size_t size)
+{
+    char *str = malloc(size + 1);
+    memcpy(str, data, size);
+    str[size] = '\0';
+    return str;
+}
@@ -0,0 +1,18 @@
+
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "node.h"
+#include "vector.h"
+#include "../lisp.h" /* entry points from lisp.c, built with -DCLISP_NO_MAIN */
+
+/* libFuzzer entry point; fuzz/main.c drives it for AFL and for replays */
+int LLVMFuzzerTestOneInput(const uint8_t *, size_t);
+
+char *fuzz_string(const uint8_t *, size_t);
+
+#endif
+
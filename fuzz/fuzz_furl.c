@@ -0,0 +1,32 @@
+
+#include "fuzz.h"
+
+/* furl on token streams the lexer would never produce on its own, such as
+ * long runs of unbalanced or mismatched braces */
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const char braces[] = "()[]{}";
+    static const enum node_type kinds[] = { T_LIST, T_VECTOR, T_MAP };
+    struct vector tokens, forest;
+    struct node node;
+    size_t ind;
+    vector_init(&tokens, sizeof(struct node));
+    vector_init(&forest, sizeof(struct vector));
+    node_init(&node);
+    for (ind = 0; ind < size; ++ind) {
+        if (data[ind] & 4) {
+            size_t pick = (data[ind] >> 3) % 3;
+            node_set(&node, kinds[pick],
+                    (union node_data){ .c = braces[pick * 2 + (data[ind] & 1)] });
+        }
+        else
+            node_set(&node, T_INT, (union node_data){ .i = data[ind] });
+        vector_push(&tokens, &node);
+    }
+    furl(&forest, &tokens);
+    vector_free(&tokens);
+    dropForest(&forest);
+    vector_free(&forest);
+    return 0;
+}
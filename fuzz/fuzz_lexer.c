@@ -0,0 +1,29 @@
+
+#include <stdlib.h>
+
+#include "fuzz.h"
+
+/* differential: the hand-written lexer must agree with the regex lexer */
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    char *line = fuzz_string(data, size);
+    struct vector scanned, matched;
+    struct node *a, *b;
+    size_t ind;
+    vector_init(&scanned, sizeof(struct node));
+    vector_init(&matched, sizeof(struct node));
+    if (lex(line, &scanned, 0, NULL) != lex(line, &matched, 1, NULL)
+            || vector_size(&scanned) != vector_size(&matched))
+        abort();
+    for (ind = 0; ind < vector_size(&scanned); ++ind) {
+        a = vector_get(&scanned, ind);
+        b = vector_get(&matched, ind);
+        if (!node_equal(a, b))
+            abort();
+    }
+    freeTree(&scanned);
+    freeTree(&matched);
+    free(line);
+    return 0;
+}
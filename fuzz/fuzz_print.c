@@ -0,0 +1,92 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fuzz.h"
+
+/* nil, booleans, ints, chars and braces print as text that reads back to
+ * the same tokens; symbols, floats and wide or unsigned numbers do not */
+static int
+round_trips(struct vector *tree)
+{
+    size_t ind, endind;
+    struct node *node;
+    for (ind = 0, endind = vector_size(tree); ind < endind; ++ind) {
+        node = vector_get(tree, ind);
+        switch (node->type) {
+            case T_NIL: case T_BOOL: case T_INT: case T_CHAR:
+            case T_LIST: case T_VECTOR: case T_MAP:
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* read, PRINT, then read the printed text back and PRINT it again; PRINT
+ * writes to stdout, which points at a scratch file for the whole run. Sets
+ * *stable when the first form is made only of atoms that round-trip. */
+static char *
+read_print(char *line, size_t *forms, int *stable)
+{
+    struct vector forest;
+    size_t ind, size;
+    char *out;
+    vector_init(&forest, sizeof(struct vector));
+    tokenize(line, &forest);
+    *forms = vector_size(&forest);
+    *stable = *forms && round_trips(vector_get(&forest, 0));
+    rewind(stdout);
+    if (ftruncate(fileno(stdout), 0))
+        abort();
+    for (ind = 0; ind < *forms; ++ind)
+        PRINT(vector_get(&forest, ind));
+    fflush(stdout);
+    size = ftell(stdout);
+    out = malloc(size + 1);
+    rewind(stdout);
+    if (fread(out, 1, size, stdout) != size)
+        abort();
+    out[size] = '\0';
+    dropForest(&forest);
+    vector_free(&forest);
+    return out;
+}
+
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static int ready = 0;
+    char path[] = "/tmp/clisp-fuzz-XXXXXX", *line, *printed, *line2, *reprinted;
+    size_t forms, lines, ind;
+    int stable, ignored;
+    if (!ready) {
+        close(mkstemp(path));
+        if (!freopen(path, "w+", stdout))
+            abort();
+        unlink(path);
+        ready = 1;
+    }
+    line = fuzz_string(data, size);
+    printed = read_print(line, &forms, &stable);
+    for (ind = 0, lines = 0; printed[ind]; ++ind)
+        lines += printed[ind] == '\n';
+    if (lines != forms) /* one line per form, newlines inside are escaped */
+        abort();
+    /* tokenize stops at the first newline, so feed back the first form;
+     * printing it again must give the same text */
+    line2 = strtok(printed, "\n");
+    if (line2) {
+        reprinted = read_print(line2, &forms, &ignored);
+        if (stable && (strncmp(reprinted, line2, strlen(line2))
+                    || strcmp(reprinted + strlen(line2), "\n")))
+            abort();
+        free(reprinted);
+    }
+    free(printed);
+    free(line);
+    return 0;
+}
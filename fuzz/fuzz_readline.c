@@ -0,0 +1,27 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz.h"
+
+/* the incremental reader fed the input one line at a time */
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    char *input = fuzz_string(data, size), *line, *next;
+    struct readstate state;
+    struct vector forest;
+    readInit(&state);
+    vector_init(&forest, sizeof(struct vector));
+    for (line = input; line; line = next) {
+        next = strchr(line, '\n');
+        if (next)
+            *next++ = '\0';
+        readLine(&state, line, &forest);
+    }
+    dropForest(&forest);
+    vector_free(&forest);
+    readFree(&state);
+    free(input);
+    return 0;
+}
@@ -0,0 +1,18 @@
+
+#include <stdlib.h>
+
+#include "fuzz.h"
+
+/* lexing and tree building of arbitrary lines */
+int
+LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    char *line = fuzz_string(data, size);
+    struct vector forest;
+    vector_init(&forest, sizeof(struct vector));
+    tokenize(line, &forest);
+    dropForest(&forest);
+    vector_free(&forest);
+    free(line);
+    return 0;
+}
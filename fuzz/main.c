@@ -0,0 +1,42 @@
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fuzz.h"
+
+/* Standalone driver for builds without libFuzzer: runs every file named on
+ * the command line through the target, or stdin when there are none (the
+ * way AFL feeds inputs). */
+
+static void
+run(FILE *in)
+{
+    size_t size = 0, cap = 1 << 12, count;
+    uint8_t *data = malloc(cap);
+    while ((count = fread(data + size, 1, cap - size, in)) > 0) {
+        size += count;
+        if (size == cap)
+            data = realloc(data, cap *= 2);
+    }
+    LLVMFuzzerTestOneInput(data, size);
+    free(data);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ind;
+    FILE *in;
+    if (argc < 2)
+        run(stdin);
+    for (ind = 1; ind < argc; ++ind) {
+        in = fopen(argv[ind], "rb");
+        if (!in) {
+            perror(argv[ind]);
+            return 1;
+        }
+        run(in);
+        fclose(in);
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "map.h"
+#include "stats.h"
+
+static int map_alloc(struct map *map, size_t capacity);
+static void map_resize(struct map *map, size_t capacity);
+
+/* bit i is set when control byte pos + i equals tag */
+static unsigned
+map_match(struct map *map, size_t pos, signed char tag)
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((__m128i *)(map->ctrl + pos));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#else
+    unsigned bits = 0, ind;
+    for (ind = 0; ind < MAP_GROUP; ++ind)
+        bits |= (unsigned)(map->ctrl[pos + ind] == tag) << ind;
+    return bits;
+#endif
+}
+
+/* bit i is set when control byte pos + i is MAP_EMPTY or MAP_DELETED */
+static unsigned
+map_match_free(struct map *map, size_t pos)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128((__m128i *)(map->ctrl + pos)));
+#else
+    unsigned bits = 0, ind;
+    for (ind = 0; ind < MAP_GROUP; ++ind)
+        bits |= (unsigned)(map->ctrl[pos + ind] < 0) << ind;
+    return bits;
+#endif
+}
+
+static void
+map_set_ctrl(struct map *map, size_t index, signed char tag)
+{
+    map->ctrl[index] = tag;
+    if (index < MAP_GROUP)
+        map->ctrl[map->capacity + index] = tag;
+}
+
+static int
+map_alloc(struct map *map, size_t capacity)
+{
+    map->ctrl = malloc(capacity + MAP_GROUP);
+    map->entries = malloc(capacity * sizeof(struct map_entry));
+    if (!map->ctrl || !map->entries) {
+        free(map->ctrl);
+        free(map->entries);
+        map->ctrl = NULL;
+        map->entries = NULL;
+        map->capacity = 0;
+        return 0;
+    }
+    memset(map->ctrl, MAP_EMPTY, capacity + MAP_GROUP);
+    map->capacity = capacity;
+    map->size = 0;
+    map->deleted = 0;
+    return 1;
+}
+
+void
+map_init(struct map *map)
+{
+    map_alloc(map, MAP_INIT_CAPACITY);
+}
+
+size_t
+map_size(struct map *map)
+{
+    return map->size;
+}
+
+/* index of key's slot, or capacity when the key is absent */
+static size_t
+map_find(struct map *map, struct node *key, unsigned long hash)
+{
+    size_t mask = map->capacity - 1, pos = (hash >> 7) & mask, step = 0, index;
+    signed char tag = hash & 0x7f;
+    unsigned bits;
+    for (;;) {
+        for (bits = map_match(map, pos, tag); bits; bits &= bits - 1) {
+            index = (pos + __builtin_ctz(bits)) & mask;
+            if (node_equal(&map->entries[index].key, key))
+                return index;
+        }
+        if (map_match(map, pos, MAP_EMPTY))
+            return map->capacity;
+        step += MAP_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+/* first empty or deleted slot on key's probe sequence */
+static size_t
+map_find_free(struct map *map, unsigned long hash)
+{
+    size_t mask = map->capacity - 1, pos = (hash >> 7) & mask, step = 0;
+    unsigned bits;
+    for (;;) {
+        bits = map_match_free(map, pos);
+        if (bits)
+            return (pos + __builtin_ctz(bits)) & mask;
+        step += MAP_GROUP;
+        pos = (pos + step) & mask;
+    }
+}
+
+static void
+map_resize(struct map *map, size_t capacity)
+{
+    struct map old = *map;
+    size_t ind, index;
+    unsigned long hash;
+    if (!map_alloc(map, capacity)) {
+        *map = old;
+        return;
+    }
+    STATS_ADD(STATS_MAP_RESIZES, 1);
+    for (ind = 0; ind < old.capacity; ++ind) {
+        if (old.ctrl[ind] < 0)
+            continue;
+        hash = node_hash(&old.entries[ind].key);
+        index = map_find_free(map, hash);
+        map_set_ctrl(map, index, hash & 0x7f);
+        map->entries[index] = old.entries[ind];
+        ++map->size;
+    }
+    free(old.ctrl);
+    free(old.entries);
+}
+
+struct node *
+map_get(struct map *map, struct node *key)
+{
+    size_t index;
+    if (!map->capacity)
+        return NULL;
+    index = map_find(map, key, node_hash(key));
+    return index < map->capacity ? &map->entries[index].value : NULL;
+}
+
+struct node *
+map_put(struct map *map, struct node *key, struct node *value)
+{
+    size_t index;
+    unsigned long hash;
+    if (!map->capacity)
+        return NULL;
+    hash = node_hash(key);
+    index = map_find(map, key, hash);
+    if (index == map->capacity) {
+        /* keep at most 7/8 of the slots in use, counting tombstones */
+        if ((map->size + map->deleted + 1) * 8 > map->capacity * 7) {
+            map_resize(map, map->size * 16 > map->capacity * 7
+                    ? map->capacity * 2 : map->capacity);
+            if ((map->size + map->deleted + 1) * 8 > map->capacity * 7)
+                return NULL;
+        }
+        index = map_find_free(map, hash);
+        if (map->ctrl[index] == MAP_DELETED)
+            --map->deleted;
+        map_set_ctrl(map, index, hash & 0x7f);
+        map->entries[index].key = *key;
+        ++map->size;
+    }
+    map->entries[index].value = *value;
+    return &map->entries[index].value;
+}
+
+int
+map_remove(struct map *map, struct node *key, struct node *value)
+{
+    size_t index;
+    if (!map->capacity)
+        return 0;
+    index = map_find(map, key, node_hash(key));
+    if (index == map->capacity)
+        return 0;
+    if (value) /* if value is NULL, don't copy into */
+        *value = map->entries[index].value;
+    map_set_ctrl(map, index, MAP_DELETED);
+    --map->size;
+    ++map->deleted;
+    return 1;
+}
+
+/* iterates live entries in slot order; start *index at 0 */
+struct map_entry *
+map_next(struct map *map, size_t *index)
+{
+    while (*index < map->capacity) {
+        if (map->ctrl[(*index)++] >= 0)
+            return &map->entries[*index - 1];
+    }
+    return NULL;
+}
+
+void
+map_clear(struct map *map)
+{
+    if (!map->capacity)
+        return;
+    memset(map->ctrl, MAP_EMPTY, map->capacity + MAP_GROUP);
+    map->size = 0;
+    map->deleted = 0;
+}
+
+void
+map_free(struct map *map)
+{
+    free(map->ctrl);
+    free(map->entries);
+}
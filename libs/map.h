@@ -0,0 +1,49 @@
+
+#ifndef MAP_INIT_CAPACITY
+#define MAP_INIT_CAPACITY 16
+#endif
+
+#ifndef MAP_H
+#define MAP_H
+
+#include <stdlib.h>
+
+#include "node.h"
+
+/* SwissTable-style open addressing: one control byte per slot holds either
+ * MAP_EMPTY, MAP_DELETED or the low 7 bits of the key's hash, and lookups
+ * compare a group of MAP_GROUP control bytes at a time (with SSE2 when the
+ * target has it). The first MAP_GROUP control bytes are mirrored past the end
+ * so that a group starting near the end never wraps. */
+
+#define MAP_GROUP   16
+#define MAP_EMPTY   ((signed char)-128)
+#define MAP_DELETED ((signed char)-2)
+
+struct map_entry {
+    struct node key;
+    struct node value;
+};
+
+struct map {
+    signed char *ctrl;         /* capacity + MAP_GROUP control bytes */
+    struct map_entry *entries; /* capacity slots */
+    size_t capacity;           /* power of two, at least MAP_GROUP */
+    size_t size;               /* live entries */
+    size_t deleted;            /* MAP_DELETED slots */
+};
+
+void map_init(struct map *);
+size_t map_size(struct map *);
+
+struct node* map_get(struct map *, struct node *);
+struct node* map_put(struct map *, struct node *, struct node *);
+int map_remove(struct map *, struct node *, struct node *);
+
+struct map_entry* map_next(struct map *, size_t *);
+
+void map_clear(struct map *);
+void map_free(struct map *);
+
+#endif
+
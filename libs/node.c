@@ -1,5 +1,8 @@
 
+#include <string.h>
+
 #include "node.h"
+#include "map.h"
 
 enum node_type
 node_get_type(struct node *node) {
@@ -50,3 +53,144 @@ node_set_child(struct node *node, struct node *child)
     node->child = child;
 }
 
+
+static unsigned long
+node_mix(unsigned long long x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+/* a T_STRING hashes and compares like the [chars] vector that the same
+ * string reads as, so line-seq lines can look up literal keys */
+static unsigned long long
+node_hash_string(char *s)
+{
+    unsigned long long hash = T_VECTOR + '[';
+    struct node chr;
+    node_init(&chr);
+    chr.type = T_CHAR;
+    for (; *s; ++s) {
+        chr.data.c = *s;
+        hash = hash * 31 + node_hash(&chr);
+    }
+    chr.type = T_VECTOR;
+    chr.data.c = ']';
+    return hash * 31 + node_hash(&chr);
+}
+
+static int
+node_equal_string(char *s, struct node *vector)
+{
+    struct node *child;
+    if (vector->type != T_VECTOR || vector->data.c != '[')
+        return 0;
+    for (child = vector->child; child && child->type == T_CHAR; child = child->sibling, ++s)
+        if (!*s || child->data.c != *s)
+            return 0;
+    return !*s && child && child->type == T_VECTOR && child->data.c == ']';
+}
+
+/* atoms hash by value and symbols by name; a brace node hashes the whole
+ * form under it, so string literals ([chars]) work as keys too */
+unsigned long
+node_hash(struct node *node)
+{
+    unsigned long long hash = node->type;
+    struct node *child;
+    struct map_entry *entry;
+    size_t ind;
+    double d;
+    char *s;
+    switch (node->type) {
+        case T_BOOL:
+        case T_CHAR:       hash += (unsigned char)node->data.c; break;
+        case T_INT:        hash += node->data.i; break;
+        case T_LONG:       hash += node->data.l; break;
+        case T_UINT:       hash += node->data.ui; break;
+        case T_ULONG:      hash += node->data.ul; break;
+        case T_DOUBLE:
+        case T_LONGDOUBLE:
+            d = node->type == T_DOUBLE ? node->data.d : (double)node->data.ld;
+            if (d == 0)
+                d = 0; /* -0.0 and 0.0 are equal keys */
+            memcpy(&hash, &d, sizeof(d));
+            hash += node->type;
+            break;
+        case T_STRING:     hash = node_hash_string(node->data.s); break;
+        case T_EXPR:
+        case T_FUNCTION:
+            for (hash = 14695981039346656037ull, s = node->data.s; *s; ++s)
+                hash = (hash ^ (unsigned char)*s) * 1099511628211ull;
+            break;
+        case T_POINTER:    hash += (unsigned long)node->data.n; break;
+        case T_SEQ:        hash += (unsigned long)node->data.q; break;
+        case T_HASHMAP:    /* independent of the order of the entries */
+            for (ind = 0; (entry = map_next(node->data.m, &ind));)
+                hash += node_mix(node_hash(&entry->key) * 31 + node_hash(&entry->value));
+            break;
+        case T_LIST:
+        case T_VECTOR:
+        case T_MAP:
+            hash += (unsigned char)node->data.c;
+            for (child = node->child; child; child = child->sibling)
+                hash = hash * 31 + node_hash(child);
+            break;
+        default:
+            break;
+    }
+    return node_mix(hash);
+}
+
+int
+node_equal(struct node *a, struct node *b)
+{
+    struct map_entry *entry;
+    struct node *found;
+    size_t ind;
+    if (a->type != b->type) {
+        if (a->type == T_STRING)
+            return node_equal_string(a->data.s, b);
+        if (b->type == T_STRING)
+            return node_equal_string(b->data.s, a);
+        return 0;
+    }
+    switch (a->type) {
+        case T_NIL:
+        case T_UNDEFINED:  return 1;
+        case T_INT:        return a->data.i == b->data.i;
+        case T_LONG:       return a->data.l == b->data.l;
+        case T_UINT:       return a->data.ui == b->data.ui;
+        case T_ULONG:      return a->data.ul == b->data.ul;
+        case T_DOUBLE:     return a->data.d == b->data.d;
+        case T_LONGDOUBLE: return a->data.ld == b->data.ld;
+        case T_EXPR:
+        case T_FUNCTION:
+        case T_STRING:     return strcmp(a->data.s, b->data.s) == 0;
+        case T_POINTER:    return a->data.n == b->data.n;
+        case T_SEQ:        return a->data.q == b->data.q;
+        case T_HASHMAP:
+            if (map_size(a->data.m) != map_size(b->data.m))
+                return 0;
+            for (ind = 0; (entry = map_next(a->data.m, &ind));) {
+                found = map_get(b->data.m, &entry->key);
+                if (!found || !node_equal(found, &entry->value))
+                    return 0;
+            }
+            return 1;
+        case T_LIST:
+        case T_VECTOR:
+        case T_MAP:
+            if (a->data.c != b->data.c)
+                return 0;
+            for (a = a->child, b = b->child; a && b; a = a->sibling, b = b->sibling)
+                if (!node_equal(a, b))
+                    return 0;
+            return a == b;
+        default:           return a->data.c == b->data.c;
+    }
+}
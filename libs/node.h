@@ -21,20 +21,27 @@ enum node_type {
     T_UINT, T_ULONG,
     T_DOUBLE, T_LONGDOUBLE,
     T_EXPR,
-    T_LIST, T_VECTOR,
+    T_LIST, T_VECTOR, T_MAP,
     T_FUNCTION, T_POINTER,
+    T_STRING, T_SEQ,
+    T_HASHMAP,
 };
 
+struct seq;
+struct map;
+
 union node_data {
     int i;            /* T_INT */
     long l;           /* T_LONG */
-    char c;           /* T_CHAR, T_LIST, T_VECTOR */
+    char c;           /* T_CHAR, T_LIST, T_VECTOR, T_MAP (brace tokens) */
     unsigned int ui;  /* T_UINT */
     unsigned long ul; /* T_ULONG */
     double d;         /* T_DOUBLE */
     long double ld;   /* T_LONGDOUBLE */
-    char *s;          /* T_EXPR, T_FUNCTION */
+    char *s;          /* T_EXPR, T_FUNCTION, T_STRING */
     struct node *n;   /* T_POINTER */
+    struct seq *q;    /* T_SEQ */
+    struct map *m;    /* T_HASHMAP */
 };
 
 struct node {
@@ -54,5 +61,8 @@ void node_set(struct node *, enum node_type, union node_data);
 void node_set_sibling(struct node *, struct node *);
 void node_set_child(struct node *, struct node *);
 
+unsigned long node_hash(struct node *);
+int node_equal(struct node *, struct node *);
+
 #endif
 
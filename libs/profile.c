@@ -0,0 +1,168 @@
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "profile.h"
+
+/* one distinct stack; count == 0 marks an empty slot */
+struct profile_slot {
+    unsigned long hash;
+    size_t depth;
+    size_t offset;      /* first frame in pool, root first */
+    unsigned long count;
+};
+
+static const char *volatile stack[PROFILE_MAX_DEPTH];
+static volatile sig_atomic_t depth = 0;
+
+/* samples are merged as they are taken: the handler hashes the live stack
+ * into an open-addressed table of PROFILE_TABLE_SIZE slots and only copies
+ * frames into the pool the first time a stack is seen, so a long run costs
+ * no more memory than a short one */
+static struct profile_slot *table = NULL;
+static size_t used = 0;
+static const char **pool = NULL;
+static size_t poolsize = 0;
+static volatile unsigned long dropped = 0;
+static FILE *out = NULL;
+
+static int
+profile_same(struct profile_slot *slot, unsigned long hash, size_t count)
+{
+    size_t ind;
+    if (slot->hash != hash || slot->depth != count)
+        return 0;
+    for (ind = 0; ind < count; ++ind)
+        if (pool[slot->offset + ind] != stack[ind])
+            return 0;
+    return 1;
+}
+
+static void
+profile_sample(int sig)
+{
+    size_t ind, count;
+    unsigned long hash = 14695981039346656037ul;
+    struct profile_slot *slot;
+    (void)sig;
+    count = depth < PROFILE_MAX_DEPTH ? depth : PROFILE_MAX_DEPTH;
+    if (!count)
+        return;
+    for (ind = 0; ind < count; ++ind)
+        hash = (hash ^ (uintptr_t)stack[ind]) * 1099511628211ul;
+    for (ind = hash;; ++ind) {
+        slot = &table[ind & (PROFILE_TABLE_SIZE - 1)];
+        if (!slot->count)
+            break;
+        if (profile_same(slot, hash, count)) {
+            ++slot->count;
+            return;
+        }
+    }
+    /* a new stack; keep the table at most 3/4 full so probes stay short */
+    if (4 * (used + 1) > 3 * PROFILE_TABLE_SIZE || poolsize + count > PROFILE_POOL_SIZE) {
+        ++dropped;
+        return;
+    }
+    for (ind = 0; ind < count; ++ind)
+        pool[poolsize + ind] = stack[ind];
+    slot->hash = hash;
+    slot->depth = count;
+    slot->offset = poolsize;
+    slot->count = 1;
+    poolsize += count;
+    ++used;
+}
+
+static void
+profile_free(void)
+{
+    free(table);
+    free(pool);
+    if (out)
+        fclose(out);
+    table = NULL;
+    pool = NULL;
+    out = NULL;
+}
+
+/* the output file is opened here so that a bad path fails before the run */
+int
+profile_start(const char *path)
+{
+    struct sigaction action;
+    struct itimerval timer;
+    table = calloc(PROFILE_TABLE_SIZE, sizeof(*table));
+    pool = malloc(PROFILE_POOL_SIZE * sizeof(*pool));
+    out = fopen(path, "w");
+    if (!table || !pool || !out) {
+        profile_free();
+        return 1;
+    }
+    used = poolsize = dropped = 0;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_sample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, NULL)) {
+        profile_free();
+        return 2;
+    }
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = PROFILE_INTERVAL_US;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL)) {
+        signal(SIGPROF, SIG_DFL);
+        profile_free();
+        return 3;
+    }
+    return 0;
+}
+
+void
+profile_push(const char *name)
+{
+    if (depth < PROFILE_MAX_DEPTH)
+        stack[depth] = name;
+    ++depth;
+}
+
+void
+profile_pop(void)
+{
+    if (depth)
+        --depth;
+}
+
+int
+profile_stop(void)
+{
+    size_t ind, frame;
+    int err;
+    struct itimerval timer;
+    struct profile_slot *slot;
+    if (!pool)
+        return 1;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    signal(SIGPROF, SIG_IGN);
+    for (ind = 0; ind < PROFILE_TABLE_SIZE; ++ind) {
+        slot = &table[ind];
+        if (!slot->count)
+            continue;
+        for (frame = 0; frame < slot->depth; ++frame)
+            fprintf(out, "%s%s", frame ? ";" : "", pool[slot->offset + frame]);
+        fprintf(out, " %lu\n", slot->count);
+    }
+    if (dropped)
+        fprintf(stderr, "profile: too many distinct stacks, dropped %lu samples\n", dropped);
+    err = ferror(out);
+    err = fclose(out) || err;
+    out = NULL;
+    profile_free();
+    return err ? 4 : 0;
+}
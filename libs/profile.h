@@ -0,0 +1,33 @@
+
+#ifndef PROFILE_INTERVAL_US
+#define PROFILE_INTERVAL_US 1000
+#endif
+
+#ifndef PROFILE_MAX_DEPTH
+#define PROFILE_MAX_DEPTH 128
+#endif
+
+#ifndef PROFILE_POOL_SIZE
+#define PROFILE_POOL_SIZE (1 << 20)
+#endif
+
+#ifndef PROFILE_TABLE_SIZE
+#define PROFILE_TABLE_SIZE (1 << 14) /* distinct stacks, a power of two */
+#endif
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/* Sampling profiler over the interpreter's own frames. Frames are pushed and
+ * popped around every interpreted call; SIGPROF counts the live stack in a
+ * preallocated hash table and profile_stop writes it out as folded stacks
+ * for flamegraph.pl. Frame names are not copied and must outlive the profile. */
+
+int profile_start(const char *);
+int profile_stop(void);
+
+void profile_push(const char *);
+void profile_pop(void);
+
+#endif
+
@@ -0,0 +1,86 @@
+
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "reader.h"
+#include "stats.h"
+
+static int reader_fill(struct reader *reader);
+
+void
+reader_init(struct reader *reader, int fd)
+{
+    reader->fd = fd;
+    reader->capacity = READER_INIT_CAPACITY;
+    reader->start = 0;
+    reader->end = 0;
+    reader->eof = 0;
+    reader->buffer = malloc(READER_INIT_CAPACITY);
+    if (!reader->buffer)
+        reader->capacity = 0;
+}
+
+static int
+reader_fill(struct reader *reader)
+{
+    ssize_t count;
+    char *buffer;
+    if (reader->start) { /* slide the partial line to the front */
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        STATS_ADD(STATS_BYTES_COPIED, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    if (reader->end + 1 >= reader->capacity) { /* one line fills the buffer */
+        buffer = realloc(reader->buffer, reader->capacity * 2);
+        if (!buffer)
+            return 0;
+        reader->buffer = buffer;
+        reader->capacity *= 2;
+    }
+    do {
+        count = read(reader->fd, reader->buffer + reader->end,
+                reader->capacity - reader->end - 1);
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        reader->eof = 1;
+        return 0;
+    }
+    reader->end += count;
+    return 1;
+}
+
+char *
+reader_line(struct reader *reader)
+{
+    char *line, *newline;
+    if (!reader->capacity)
+        return NULL;
+    for (;;) {
+        line = reader->buffer + reader->start;
+        newline = memchr(line, '\n', reader->end - reader->start);
+        if (newline) {
+            *newline = '\0';
+            reader->start = newline - reader->buffer + 1;
+            return line;
+        }
+        if (reader->eof || !reader_fill(reader))
+            break;
+    }
+    /* last line without a trailing newline; fill keeps one spare byte */
+    if (reader->start == reader->end)
+        return NULL;
+    line = reader->buffer + reader->start;
+    reader->buffer[reader->end] = '\0';
+    reader->start = reader->end;
+    return line;
+}
+
+void
+reader_free(struct reader *reader)
+{
+    free(reader->buffer);
+}
@@ -0,0 +1,25 @@
+
+#ifndef READER_INIT_CAPACITY
+#define READER_INIT_CAPACITY 65536
+#endif
+
+#ifndef READER_H
+#define READER_H
+
+#include <stdlib.h>
+
+struct reader {
+    int fd;          /* file descriptor read from */
+    char *buffer;    /* chunk buffer */
+    size_t capacity; /* allocated bytes in buffer */
+    size_t start;    /* first unconsumed byte */
+    size_t end;      /* one past the last valid byte */
+    int eof;         /* set once read() returns 0 or fails */
+};
+
+void reader_init(struct reader *, int);
+char* reader_line(struct reader *);
+void reader_free(struct reader *);
+
+#endif
+
@@ -0,0 +1,240 @@
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "seq.h"
+
+static struct seq*
+seq_cell(struct seq_source *source)
+{
+    struct seq *seq = malloc(sizeof(struct seq));
+    ++source->refs;
+    seq->source = source;
+    seq->state = SEQ_PENDING;
+    node_init(&seq->first);
+    seq->hold = NULL;
+    seq->rest = NULL;
+    seq->refs = 1;
+    return seq;
+}
+
+struct seq*
+seq_new(seq_step step, void (*release)(void *), void (*drop)(void *), void *env)
+{
+    struct seq_source *source = malloc(sizeof(struct seq_source));
+    source->step = step;
+    source->release = release;
+    source->drop = drop;
+    source->env = env;
+    source->refs = 0;
+    return seq_cell(source);
+}
+
+struct seq*
+seq_retain(struct seq *seq)
+{
+    ++seq->refs;
+    return seq;
+}
+
+/* iterative, so dropping the head of a long realized chain stays flat */
+void
+seq_release(struct seq *seq)
+{
+    struct seq *rest;
+    struct seq_source *source;
+    while (seq && --seq->refs == 0) {
+        rest = seq->rest;
+        source = seq->source;
+        if (seq->hold && source->release)
+            source->release(seq->hold);
+        if (--source->refs == 0) {
+            if (source->drop)
+                source->drop(source->env);
+            free(source);
+        }
+        free(seq);
+        seq = rest;
+    }
+}
+
+/* runs the thunk once; cells are only reached through their predecessor, so
+ * the source's steps happen in order */
+static void
+seq_force(struct seq *seq)
+{
+    if (seq->state != SEQ_PENDING)
+        return;
+    if (seq->source->step(seq->source->env, &seq->first, &seq->hold)) {
+        seq->state = SEQ_CELL;
+        seq->rest = seq_cell(seq->source);
+    } else {
+        seq->state = SEQ_END;
+    }
+}
+
+/* the element of seq, or NULL at the end */
+struct node*
+seq_first(struct seq *seq)
+{
+    seq_force(seq);
+    return seq->state == SEQ_CELL ? &seq->first : NULL;
+}
+
+/* moves the caller's reference from seq to the cell after it; the end of a
+ * sequence is its own successor */
+struct seq*
+seq_next(struct seq *seq)
+{
+    struct seq *rest;
+    seq_force(seq);
+    if (seq->state != SEQ_CELL)
+        return seq;
+    rest = seq_retain(seq->rest);
+    seq_release(seq);
+    return rest;
+}
+
+static void
+seq_release_hold(void *hold)
+{
+    seq_release(hold);
+}
+
+static void
+seq_drop_cursor(void *env)
+{
+    seq_release(*(struct seq **)env);
+    free(env);
+}
+
+/* map, filter and take keep a cursor into their source as the first member
+ * of their env; an element they pass on holds the source cell it came from */
+
+struct seq_map_env {
+    struct seq *cursor;
+    seq_map_fn fn;
+    void *ctx;
+};
+
+static int
+seq_map_step(void *env, struct node *out, void **hold)
+{
+    struct seq_map_env *map = env;
+    struct node *item = seq_first(map->cursor);
+    if (!item)
+        return 0;
+    map->fn(item, out, map->ctx);
+    *hold = seq_retain(map->cursor);
+    map->cursor = seq_next(map->cursor);
+    return 1;
+}
+
+struct seq*
+seq_map(struct seq *source, seq_map_fn fn, void *ctx)
+{
+    struct seq_map_env *map = malloc(sizeof(struct seq_map_env));
+    map->cursor = source;
+    map->fn = fn;
+    map->ctx = ctx;
+    return seq_new(seq_map_step, seq_release_hold, seq_drop_cursor, map);
+}
+
+struct seq_filter_env {
+    struct seq *cursor;
+    seq_pred_fn pred;
+    void *ctx;
+};
+
+static int
+seq_filter_step(void *env, struct node *out, void **hold)
+{
+    struct seq_filter_env *filter = env;
+    struct node *item;
+    for (; (item = seq_first(filter->cursor)); filter->cursor = seq_next(filter->cursor)) {
+        if (filter->pred(item, filter->ctx)) {
+            *out = *item;
+            *hold = seq_retain(filter->cursor);
+            filter->cursor = seq_next(filter->cursor);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+struct seq*
+seq_filter(struct seq *source, seq_pred_fn pred, void *ctx)
+{
+    struct seq_filter_env *filter = malloc(sizeof(struct seq_filter_env));
+    filter->cursor = source;
+    filter->pred = pred;
+    filter->ctx = ctx;
+    return seq_new(seq_filter_step, seq_release_hold, seq_drop_cursor, filter);
+}
+
+struct seq_take_env {
+    struct seq *cursor;
+    size_t left;
+};
+
+static int
+seq_take_step(void *env, struct node *out, void **hold)
+{
+    struct seq_take_env *take = env;
+    struct node *item;
+    if (!take->left) { /* stop pulling on the source right away */
+        seq_release(take->cursor);
+        take->cursor = NULL;
+        return 0;
+    }
+    item = seq_first(take->cursor);
+    if (!item)
+        return 0;
+    *out = *item;
+    *hold = seq_retain(take->cursor);
+    take->cursor = seq_next(take->cursor);
+    --take->left;
+    return 1;
+}
+
+struct seq*
+seq_take(struct seq *source, size_t count)
+{
+    struct seq_take_env *take = malloc(sizeof(struct seq_take_env));
+    take->cursor = source;
+    take->left = count;
+    return seq_new(seq_take_step, seq_release_hold, seq_drop_cursor, take);
+}
+
+/* folds every element into acc; returns how many there were */
+size_t
+seq_reduce(struct seq *seq, seq_reduce_fn fn, struct node *acc, void *ctx)
+{
+    size_t count = 0;
+    struct node *item;
+    for (; (item = seq_first(seq)); seq = seq_next(seq), ++count)
+        fn(acc, item, ctx);
+    seq_release(seq);
+    return count;
+}
+
+static int
+seq_lines_step(void *env, struct node *out, void **hold)
+{
+    char *line = reader_line(env);
+    size_t len;
+    if (!line)
+        return 0;
+    len = strlen(line) + 1;
+    *hold = memcpy(malloc(len), line, len); /* the reader reuses its buffer */
+    out->type = T_STRING;
+    out->data.s = *hold;
+    return 1;
+}
+
+/* the lines of reader as T_STRING elements; the caller keeps the reader */
+struct seq*
+seq_lines(struct reader *reader)
+{
+    return seq_new(seq_lines_step, free, NULL, reader);
+}
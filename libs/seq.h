@@ -0,0 +1,62 @@
+
+#ifndef SEQ_H
+#define SEQ_H
+
+#include <stdlib.h>
+
+#include "node.h"
+#include "reader.h"
+
+/* Lazy sequences: a chain of cells, each realized by a call to its source's
+ * step function (the thunk) the first time it is looked at, after which its
+ * element and the cell after it are memoized. Cells are reference counted
+ * and a consumer drops each cell as it moves past it, so walking a sequence
+ * keeps only the cells between the slowest holder and the newest one alive.
+ *
+ * The constructors and seq_reduce take over the caller's reference to their
+ * source sequence. A T_SEQ node in a tree owns one reference, which freeTree
+ * releases; elements handed out by a sequence are borrowed from their cell. */
+
+/* realizes the next element into *out and sets *hold to whatever must stay
+ * alive for as long as it does (or NULL); returns 0 at the end */
+typedef int (*seq_step)(void *, struct node *, void **);
+
+struct seq_source {
+    seq_step step;           /* thunk */
+    void (*release)(void *); /* frees an element's hold */
+    void (*drop)(void *);    /* frees env */
+    void *env;               /* step's state */
+    size_t refs;             /* cells using this source */
+};
+
+enum seq_state { SEQ_PENDING, SEQ_CELL, SEQ_END };
+
+struct seq {
+    struct seq_source *source;
+    enum seq_state state;
+    struct node first; /* memoized element */
+    void *hold;        /* keeps first's data alive */
+    struct seq *rest;  /* memoized next cell */
+    size_t refs;
+};
+
+typedef void (*seq_map_fn)(struct node *, struct node *, void *);
+typedef int (*seq_pred_fn)(struct node *, void *);
+typedef void (*seq_reduce_fn)(struct node *, struct node *, void *);
+
+struct seq* seq_new(seq_step, void (*)(void *), void (*)(void *), void *);
+struct seq* seq_retain(struct seq *);
+void seq_release(struct seq *);
+
+struct node* seq_first(struct seq *);
+struct seq* seq_next(struct seq *);
+
+struct seq* seq_map(struct seq *, seq_map_fn, void *);
+struct seq* seq_filter(struct seq *, seq_pred_fn, void *);
+struct seq* seq_take(struct seq *, size_t);
+size_t seq_reduce(struct seq *, seq_reduce_fn, struct node *, void *);
+
+struct seq* seq_lines(struct reader *);
+
+#endif
+
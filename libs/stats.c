@@ -0,0 +1,44 @@
+
+#ifdef STATS
+
+#include <stdio.h>
+
+#include "stats.h"
+
+struct stats stats;
+
+static const char *phase_names[STATS_PHASES] = {
+    "read", "tokenize", "furl", "print"
+};
+
+static const char *counter_names[STATS_COUNTERS] = {
+    "nodes", "vector_reallocs", "bytes_copied", "regex_calls", "scan_calls",
+    "map_resizes"
+};
+
+void
+stats_report(FILE *out, int json)
+{
+    int ind;
+    if (json) {
+        fprintf(out, "{\"unit\": \"%s\", \"phases\": {", STATS_UNIT);
+        for (ind = 0; ind < STATS_PHASES; ++ind)
+            fprintf(out, "%s\"%s\": {\"calls\": %llu, \"total\": %llu}", ind ? ", " : "",
+                    phase_names[ind], stats.calls[ind], stats.ticks[ind]);
+        fprintf(out, "}, \"counters\": {");
+        for (ind = 0; ind < STATS_COUNTERS; ++ind)
+            fprintf(out, "%s\"%s\": %llu", ind ? ", " : "",
+                    counter_names[ind], stats.counters[ind]);
+        fprintf(out, "}}\n");
+        return;
+    }
+    fprintf(out, "%-16s %12s %16s %14s\n", "phase", "calls", STATS_UNIT, "per call");
+    for (ind = 0; ind < STATS_PHASES; ++ind)
+        fprintf(out, "%-16s %12llu %16llu %14llu\n", phase_names[ind], stats.calls[ind],
+                stats.ticks[ind], stats.calls[ind] ? stats.ticks[ind] / stats.calls[ind] : 0);
+    fprintf(out, "\n%-16s %12s\n", "counter", "value");
+    for (ind = 0; ind < STATS_COUNTERS; ++ind)
+        fprintf(out, "%-16s %12llu\n", counter_names[ind], stats.counters[ind]);
+}
+
+#endif
@@ -0,0 +1,72 @@
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+/* timed phases, inclusive of the phases they call */
+enum stats_phase {
+    STATS_READ,
+    STATS_TOKENIZE,
+    STATS_FURL,
+    STATS_PRINT,
+    STATS_PHASES
+};
+
+enum stats_counter {
+    STATS_NODES,          /* nodes built by the lexer */
+    STATS_REALLOCS,       /* successful vector_resize calls */
+    STATS_BYTES_COPIED,   /* bytes moved by vector and reader copies */
+    STATS_REGEX_CALLS,    /* regexec calls made by the reference lexer */
+    STATS_SCAN_CALLS,     /* tokens matched by the hand-written lexer */
+    STATS_MAP_RESIZES,    /* hash table rehashes in map_resize */
+    STATS_COUNTERS
+};
+
+#ifdef STATS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS_UNIT "cycles"
+static inline unsigned long long
+stats_clock(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define STATS_UNIT "ns"
+static inline unsigned long long
+stats_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+struct stats {
+    unsigned long long ticks[STATS_PHASES];
+    unsigned long long calls[STATS_PHASES];
+    unsigned long long counters[STATS_COUNTERS];
+};
+
+extern struct stats stats;
+
+#define STATS_START(phase)       unsigned long long stats_start_##phase = stats_clock()
+#define STATS_STOP(phase)        (stats.ticks[phase] += stats_clock() - stats_start_##phase, \
+                                  ++stats.calls[phase])
+#define STATS_ADD(counter, n)    (stats.counters[counter] += (n))
+
+void stats_report(FILE *, int);
+
+#else
+
+#define STATS_START(phase)
+#define STATS_STOP(phase)
+#define STATS_ADD(counter, n)
+
+#endif
+
+#endif
+
@@ -4,6 +4,7 @@
 #include <string.h>
 
 #include "vector.h"
+#include "stats.h"
 
 static void vector_resize(struct vector *vector, size_t capacity);
 
@@ -33,6 +34,7 @@ vector_resize(struct vector *vector, size_t capacity)
         #ifdef DEBUG_ON
         fprintf(stderr, "vector resized from %zu to %zu\n", vector->capacity, capacity);
         #endif
+        STATS_ADD(STATS_REALLOCS, 1);
         vector->items = items;
         vector->capacity = capacity;
     } else {
@@ -59,6 +61,7 @@ vector_insert(struct vector *vector, size_t index, void *item) {
     }
     addr = vector->items + index * vector->itemsize;
     memcpy(addr, item, vector->itemsize);
+    STATS_ADD(STATS_BYTES_COPIED, (vector->size - index + 1) * vector->itemsize);
     ++vector->size;
     return addr;
 }
@@ -77,11 +80,12 @@ vector_remove(struct vector *vector, size_t index, void *item)
         if (!vector->capacity)
             return;
     }
-    for (ind = index; ind < vector->size; ++ind) {
+    for (ind = index; ind + 1 < vector->size; ++ind) {
         addr = vector->items + ind * vector->itemsize;
         memcpy(addr, addr + vector->itemsize, vector->itemsize);
     }
-    addr = vector->items + ind * vector->itemsize;
+    STATS_ADD(STATS_BYTES_COPIED, (vector->size - index - 1) * vector->itemsize);
+    addr = vector->items + ind * vector->itemsize; /* now-unused last slot */
     memset(addr, 0, vector->itemsize);
     --vector->size;
 }
@@ -93,6 +97,7 @@ vector_set(struct vector *vector, size_t index, void *item)
     if (vector->capacity && index < vector->size) {
         addr = vector->items + index * vector->itemsize;
         memcpy(addr, item, vector->itemsize);
+        STATS_ADD(STATS_BYTES_COPIED, vector->itemsize);
     }
     return addr;
 }
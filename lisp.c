@@ -10,6 +10,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
 
 #include <regex.h>
 #include <sys/types.h>
@@ -17,57 +20,135 @@
 #include <readline/readline.h>
 #include <readline/history.h>
 
-#include "node.h"
-#include "vector.h"
+#include "lisp.h"
+#include "stats.h"
+#include "profile.h"
 
-int main(void);
-int READ(char prompt[], struct vector *);
-struct node* EVAL(struct vector *);
-void PRINT(struct vector *);
-int tokenize(char *, struct vector *);
-int furl(struct vector *, struct vector *);
+#define BATCH_BUFSIZE (1 << 16)
 
+int main(int, char *[]);
+
+#ifndef CLISP_NO_MAIN
 int
-main(void)
+main(int argc, char *argv[])
 {
     size_t index, endindex;
+    int argind, err, batch, report = 0, status = 0;
+    char *profile = NULL;
     char prompt[101];
     struct vector forest, tree;
+    struct reader reader;
+    struct readstate state;
+    batch = !isatty(STDIN_FILENO);
+    for (argind = 1; argind < argc; ++argind) {
+        if (strcmp(argv[argind], "--batch") == 0) {
+            batch = 1;
+        } else if (strncmp(argv[argind], "--profile=", 10) == 0) {
+            profile = argv[argind] + 10;
+        } else if (strcmp(argv[argind], "--stats") == 0) {
+            report = 1;
+        } else if (strcmp(argv[argind], "--stats=json") == 0) {
+            report = 2;
+        } else {
+            fprintf(stderr, "usage: %s [--batch] [--profile=FILE] [--stats[=json]]\n", argv[0]);
+            return 2;
+        }
+    }
+#ifndef STATS
+    if (report) {
+        fputs("--stats needs a build with -DSTATS (make stats)\n", stderr);
+        return 2;
+    }
+#endif
+    if (profile && profile_start(profile)) {
+        fprintf(stderr, "could not start profiling to “%s”\n", profile);
+        return 2;
+    }
+    if (batch) {
+        /* no prompt, no history, large reads and fully buffered output */
+        reader_init(&reader, STDIN_FILENO);
+        setvbuf(stdout, NULL, _IOFBF, BATCH_BUFSIZE);
+    }
     vector_init(&forest, sizeof(struct vector));
-    snprintf(prompt, sizeof(prompt), "%s", "λ> ");
-    while (!READ(prompt, &forest)) {
+    readInit(&state);
+    for (;;) {
+        if (state.instring) /* the prompt shows how deep the open form is */
+            snprintf(prompt, sizeof(prompt), "λ\"> ");
+        else if (readDepth(&state))
+            snprintf(prompt, sizeof(prompt), "λ%zu> ", readDepth(&state));
+        else
+            snprintf(prompt, sizeof(prompt), "λ> ");
+        STATS_START(STATS_READ);
+        profile_push("READ");
+        err = READ(prompt, batch ? &reader : NULL, &state, &forest);
+        profile_pop();
+        STATS_STOP(STATS_READ);
+        if (err == EOF)
+            break;
         for (index = 0, endindex = vector_size(&forest); index < endindex; ++index) {
             vector_remove(&forest, 0, &tree);
-            vector_free(&tree);
+            STATS_START(STATS_PRINT);
+            profile_push("PRINT");
             PRINT(&tree);
+            profile_pop();
+            STATS_STOP(STATS_PRINT);
+            freeTree(&tree);
         }
     }
+    fflush(stdout);
+    if (profile && profile_stop()) {
+        fprintf(stderr, "could not write the profile to “%s”\n", profile);
+        status = 1;
+    }
+#ifdef STATS
+    if (report)
+        stats_report(stderr, report == 2);
+#endif
     vector_free(&forest);
-    return 0;
+    readFree(&state);
+    if (batch)
+        reader_free(&reader);
+    return status;
 }
+#endif
 
+/* returns EOF at end of input, otherwise the tokenize error (0 on success);
+ * a form left open by the line is finished by the following calls */
 int
-READ(char prompt[], struct vector *forest)
+READ(char prompt[], struct reader *reader, struct readstate *state, struct vector *forest)
 {
     char *line;
     int err = 0;
-    line = readline(prompt);
-    if (line) {
-        err = tokenize(line, forest);
-        if (err)
-            fputs("Fatal Error during tokenization\n", stderr);
-        else {
-            add_history(line);
-            free(line);
+    line = reader ? reader_line(reader) : readline(prompt);
+    if (!line) {
+        if (readDepth(state)) {
+            fputs("Fatal Error: Unmatched opening brace\n", stderr);
+            readReset(state);
         }
-    } else {
-        err = 1;
+        return EOF;
     }
+    STATS_START(STATS_TOKENIZE);
+    profile_push("tokenize");
+    err = readLine(state, line, forest);
+    profile_pop();
+    STATS_STOP(STATS_TOKENIZE);
+    if (err)
+        fputs("Fatal Error during tokenization\n", stderr);
+    else if (!reader && *line)
+        add_history(line);
+    if (!reader) /* reader lines live in its buffer */
+        free(line);
     return err;
 }
 
+static void printForm(struct node *);
+
 void
 printNode(struct node *node) {
+    struct map_entry *entry;
+    struct node chr;
+    size_t index;
+    int first;
     if (!node) {
         printf("nil");
         return;
@@ -104,6 +185,7 @@ printNode(struct node *node) {
             break;
         case T_LIST:
         case T_VECTOR:
+        case T_MAP:
             printf("%c", node->data.c);
             break;
         case T_UINT:
@@ -118,8 +200,8 @@ printNode(struct node *node) {
         case T_LONGDOUBLE:
             printf("%Lf", node->data.ld);
             break;
-        case T_POINTER:
-            printf("%f", node->data.d);
+        case T_POINTER: /* e.g. a form handed out by formSeq */
+            printForm(node->data.n);
             break;
         case T_EXPR:
             printf("#<%s expression>", node->data.s);
@@ -127,56 +209,90 @@ printNode(struct node *node) {
         case T_FUNCTION:
             printf("#<%s function>", node->data.s);
             break;
+        case T_STRING: /* as the [chars] vector it is equal to */
+            node_init(&chr);
+            chr.type = T_CHAR;
+            printf("[");
+            for (index = 0; node->data.s[index]; ++index) {
+                chr.data.c = node->data.s[index];
+                printf(index ? " " : "");
+                printNode(&chr);
+            }
+            printf("]");
+            break;
+        case T_SEQ:
+            printf("#<seq>");
+            break;
+        case T_HASHMAP:
+            printf("{");
+            for (index = 0, first = 1; (entry = map_next(node->data.m, &index)); first = 0) {
+                printf(first ? "" : " ");
+                printForm(&entry->key);
+                printf(" ");
+                printForm(&entry->value);
+            }
+            printf("}");
+            break;
         case T_UNDEFINED:
             printf("#<undefined>");
     }
 }
 
-void
-PRINT(struct vector *tree)
+static int
+isOpenBrace(struct node *node)
+{
+    return (node->type == T_LIST && node->data.c == '(')
+        || (node->type == T_VECTOR && node->data.c == '[')
+        || (node->type == T_MAP && node->data.c == '{');
+}
+
+static int
+isCloseBrace(struct node *node)
+{
+    return (node->type == T_LIST && node->data.c == ')')
+        || (node->type == T_VECTOR && node->data.c == ']')
+        || (node->type == T_MAP && node->data.c == '}');
+}
+
+/* prints node and, for an open brace, everything up to its close brace */
+static void
+printForm(struct node *node)
 {
-    struct node node, *nextnode;
+    struct node *next;
     struct vector parents;
-    vector_init(&parents, sizeof(struct node));
-    nextnode = vector_get(tree, 0);
-    node = *nextnode;
-    char space = 0, endbrace = 0;
-    while (nextnode && node.type != T_UNDEFINED) {
-        endbrace = (node.type == T_LIST && node.data.c == ')')
-            || (node.type == T_VECTOR && node.data.c == ']');
-        if (space && node.sibling && !endbrace)
-            printf(" ");
-        space = node.type != T_LIST && node.type != T_VECTOR;
-        printNode(&node);
-        if (endbrace && node.sibling
-                && !((node.sibling->type == T_LIST && node.sibling->data.c == ')')
-                    || (node.sibling->type == T_VECTOR && node.sibling->data.c == ']')))
-            printf(" ");
-        nextnode = node.child;
-        if (nextnode) {
+    vector_init(&parents, sizeof(struct node *));
+    while (node && node->type != T_UNDEFINED) {
+        printNode(node);
+        if (node->child) {
             vector_push(&parents, &node);
-        } else {
-            nextnode = node.sibling;
-            if (!nextnode && vector_size(&parents)) {
-                vector_pop(&parents, nextnode);
-                if (nextnode->type == T_LIST)
-                    printf(")");
-                else if (nextnode->type == T_VECTOR)
-                    printf("]");
-            }
+            node = node->child;
+            continue;
+        }
+        next = vector_size(&parents) ? node->sibling : NULL;
+        while (!next && vector_size(&parents)) {
+            vector_pop(&parents, &next);
+            next = vector_size(&parents) ? next->sibling : NULL;
         }
-        node = *nextnode;
+        if (next && !isOpenBrace(node) && !isCloseBrace(next))
+            printf(" ");
+        node = next;
     }
-    printf("\n");
     vector_free(&parents);
 }
 
+void
+PRINT(struct vector *tree)
+{
+    printForm(vector_get(tree, 0));
+    printf("\n");
+}
+
 int
 reduceSign(char *signStr, size_t signLen)
 {
     int sign = 1;
-    size_t ind = 0;
-    while (ind++ < signLen) {
+    size_t ind;
+    for (ind = 0; ind < signLen; ++ind) {
         if (signStr[ind] == '-')
             sign *= -1;
     }
@@ -228,21 +344,21 @@ s2ull(char *start, char *end, int base)
     return result;
 }
 
-int
-tokenize(char *expr, struct vector *forest)
+static regex_t regexComment     , regexSpace        , regexNilBool, regexFloat       , regexDecimal,
+               regexBinary      , regexOctal        , regexHex    , regexPostNumError, regexSymbol ,
+               regexSingleSymbol, regexSpecialSymbol, regexChar   , regexString;
+
+/* the lexer patterns are compiled once and reused for every line */
+static void
+compileRegexes(void)
 {
-    struct vector tree;
-    char *subexpr, *startchar, *endchar;
-    int state, base, sign, flag;
-    size_t index, endindex;
-    struct node node;
-    regex_t regexComment     , regexSpace        , regexNilBool, regexFloat       , regexDecimal,
-            regexBinary      , regexOctal        , regexHex    , regexPostNumError, regexSymbol ,
-            regexSingleSymbol, regexSpecialSymbol, regexChar   , regexString;
-    regmatch_t matches[5], errMatches[1];
+    static int compiled = 0;
+    if (compiled)
+        return;
+    compiled = 1;
     regcomp(&regexSpace        , "^\\s+"                           , REG_EXTENDED);
     regcomp(&regexComment      , "^;.*"                            , REG_EXTENDED);
-    regcomp(&regexNilBool      , "^(nil|true|false)"               , 0);
+    regcomp(&regexNilBool      , "^(nil|true|false)([^a-zA-Z0-9_!@#']|$)", REG_EXTENDED);
     regcomp(&regexFloat        , "^([+-]*)([0-9]*\\.[0-9]+)(d?)"   , REG_EXTENDED);
     regcomp(&regexDecimal      , "^([+-]*)([0-9]+)(u?)(l?)"        , REG_EXTENDED);
     regcomp(&regexBinary       , "^([+-]*)0[bB]([01]+)(u?)(l?)"    , REG_EXTENDED);
@@ -250,41 +366,270 @@ tokenize(char *expr, struct vector *forest)
     regcomp(&regexHex          , "^([+-]*)0[xX]([0-9a-f]+)(u?)(l?)", REG_EXTENDED);
     regcomp(&regexPostNumError , "^[a-zA-Z0-9_.]*"                 , REG_EXTENDED);
     regcomp(&regexSymbol       , "^[a-z_][a-z_0-9!@#']*"           , REG_ICASE);
-    regcomp(&regexSingleSymbol , "^[][()]"                         , REG_EXTENDED);
-    regcomp(&regexSpecialSymbol, "^[][+*=|/~()<>?!@#$%^&*=-]+"     , REG_EXTENDED);
+    regcomp(&regexSingleSymbol , "^[][(){}]"                       , REG_EXTENDED);
+    regcomp(&regexSpecialSymbol, "^[+*=|/~<>?!@#$%^&*=-]+"         , REG_EXTENDED);
     regcomp(&regexChar         , "^'(\\\\)?(.)'"                   , REG_EXTENDED);
     regcomp(&regexString       , "^\"([^\"\\]|\\\\.)*\""           , REG_EXTENDED);
-    vector_init(&tree, sizeof(struct node));
+}
+
+/* every lexer regexec goes through here so --stats can count them */
+static int
+lexMatch(regex_t *regex, char *expr, size_t nmatch, regmatch_t matches[])
+{
+    STATS_ADD(STATS_REGEX_CALLS, 1);
+    return regexec(regex, expr, nmatch, matches, 0);
+}
+
+/* lexer states: 0:error, -1:skip, 1:nil or bool, 2:float, 3:decimal,
+ *               4:binary, 5:octal, 6:hex, 7:expr, 8:char, 9:str
+ *
+ * Both matchers fill matches[] exactly as the regexes' groups would and set
+ * *suffix to the length of any junk glued onto a number. lexRegex is the
+ * reference; lexScan is the hand-written matcher tokenize uses, and the
+ * differential test in testing/tests.c keeps the two in agreement. */
+static int
+lexRegex(char *expr, regmatch_t matches[], regoff_t *suffix)
+{
+    int state;
+    regmatch_t errMatches[1];
+    compileRegexes();
+    if      (lexMatch(&regexSpace        , expr, 1, matches) == 0) state = -1;
+    else if (lexMatch(&regexComment      , expr, 1, matches) == 0) state = -1;
+    else if (lexMatch(&regexNilBool      , expr, 2, matches) == 0) state = 1;
+    else if (lexMatch(&regexFloat        , expr, 4, matches) == 0) state = 2;
+    else if (lexMatch(&regexBinary       , expr, 5, matches) == 0) state = 4;
+    else if (lexMatch(&regexHex          , expr, 5, matches) == 0) state = 6;
+    else if (lexMatch(&regexOctal        , expr, 5, matches) == 0) state = 5;
+    else if (lexMatch(&regexDecimal      , expr, 5, matches) == 0) state = 3;
+    else if (lexMatch(&regexSymbol       , expr, 1, matches) == 0) state = 7;
+    else if (lexMatch(&regexSingleSymbol , expr, 1, matches) == 0) state = 7;
+    else if (lexMatch(&regexSpecialSymbol, expr, 1, matches) == 0) state = 7;
+    else if (lexMatch(&regexChar         , expr, 3, matches) == 0) state = 8;
+    else if (lexMatch(&regexString       , expr, 1, matches) == 0) state = 9;
+    else                                                             state = 0;
+    if (state == 1) /* leave the byte after the keyword */
+        matches[0] = matches[1];
+    *suffix = 0;
+    if (state > 1 && state < 7
+            && lexMatch(&regexPostNumError, expr + matches[0].rm_eo, 1, errMatches) == 0)
+        *suffix = errMatches[0].rm_eo;
+    return state;
+}
+
+static void
+setMatch(regmatch_t *match, regoff_t start, regoff_t end)
+{
+    match->rm_so = start;
+    match->rm_eo = end;
+}
+
+static int
+isDigitOf(char c, int base)
+{
+    switch (base) {
+        case 2:  return c == '0' || c == '1';
+        case 8:  return c >= '0' && c <= '7';
+        case 10: return c >= '0' && c <= '9';
+        default: return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    }
+}
+
+static int
+isSymbolChar(char c, int first)
+{
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+        return 1;
+    return !first && ((c >= '0' && c <= '9') || c == '!' || c == '@' || c == '#' || c == '\'');
+}
+
+/* ^([+-]*)<prefix>(<digits>)(u?)(l?) with the digits starting at start */
+static int
+scanInteger(char *expr, regoff_t signs, regoff_t start, int base, regmatch_t matches[])
+{
+    regoff_t end = start;
+    while (isDigitOf(expr[end], base))
+        ++end;
+    if (end == start)
+        return 0;
+    setMatch(&matches[1], 0, signs);
+    setMatch(&matches[2], start, end);
+    setMatch(&matches[3], end, end + (expr[end] == 'u'));
+    end = matches[3].rm_eo;
+    setMatch(&matches[4], end, end + (expr[end] == 'l'));
+    setMatch(&matches[0], 0, matches[4].rm_eo);
+    return 1;
+}
+
+static int
+lexScan(char *expr, regmatch_t matches[], regoff_t *suffix)
+{
+    regoff_t ind, signs;
+    int state = 0;
+    *suffix = 0;
+    STATS_ADD(STATS_SCAN_CALLS, 1);
+    for (ind = 0; expr[ind] && strchr(" \t\n\v\f\r", expr[ind]); ++ind)
+        ;
+    if (ind) {
+        setMatch(&matches[0], 0, ind);
+        return -1;
+    }
+    if (*expr == ';') {
+        setMatch(&matches[0], 0, strlen(expr));
+        return -1;
+    }
+    if (!strncmp(expr, "nil", 3) || !strncmp(expr, "true", 4) || !strncmp(expr, "false", 5)) {
+        ind = *expr == 'f' ? 5 : *expr == 't' ? 4 : 3;
+        if (!isSymbolChar(expr[ind], 0)) { /* nilable is a symbol */
+            setMatch(&matches[0], 0, ind);
+            return 1;
+        }
+    }
+    for (signs = 0; expr[signs] == '+' || expr[signs] == '-'; ++signs)
+        ;
+    for (ind = signs; isDigitOf(expr[ind], 10); ++ind)
+        ;
+    if (expr[ind] == '.' && isDigitOf(expr[ind + 1], 10)) {
+        for (ind += 1; isDigitOf(expr[ind], 10); ++ind)
+            ;
+        setMatch(&matches[1], 0, signs);
+        setMatch(&matches[2], signs, ind);
+        setMatch(&matches[3], ind, ind + (expr[ind] == 'd'));
+        setMatch(&matches[0], 0, matches[3].rm_eo);
+        state = 2;
+    } else if (expr[signs] == '0' && (expr[signs + 1] == 'b' || expr[signs + 1] == 'B')
+            && scanInteger(expr, signs, signs + 2, 2, matches)) {
+        state = 4;
+    } else if (expr[signs] == '0' && (expr[signs + 1] == 'x' || expr[signs + 1] == 'X')
+            && scanInteger(expr, signs, signs + 2, 16, matches)) {
+        state = 6;
+    } else if (expr[signs] == '0' && scanInteger(expr, signs, signs + 1
+                + ((expr[signs + 1] == 'o' || expr[signs + 1] == 'O')
+                    && isDigitOf(expr[signs + 2], 8)), 8, matches)) {
+        state = 5;
+    } else if (scanInteger(expr, signs, signs, 10, matches)) {
+        state = 3;
+    }
+    if (state) {
+        for (ind = matches[0].rm_eo; isSymbolChar(expr[ind], 1) || isDigitOf(expr[ind], 10)
+                || expr[ind] == '.'; ++ind)
+            ;
+        *suffix = ind - matches[0].rm_eo;
+        return state;
+    }
+    if (isSymbolChar(*expr, 1)) {
+        for (ind = 1; isSymbolChar(expr[ind], 0); ++ind)
+            ;
+        setMatch(&matches[0], 0, ind);
+        return 7;
+    }
+    if (*expr && strchr("()[]{}", *expr)) {
+        setMatch(&matches[0], 0, 1);
+        return 7;
+    }
+    for (ind = 0; expr[ind] && strchr("+*=|/~<>?!@#$%^&-", expr[ind]); ++ind)
+        ;
+    if (ind) {
+        setMatch(&matches[0], 0, ind);
+        return 7;
+    }
+    if (*expr == '\'') { /* the longest match wins, so '\'' is an escaped quote */
+        if (expr[1] == '\\' && expr[2] && expr[3] == '\'') {
+            setMatch(&matches[1], 1, 2);
+            setMatch(&matches[2], 2, 3);
+            setMatch(&matches[0], 0, 4);
+            return 8;
+        }
+        if (expr[1] && expr[2] == '\'') {
+            setMatch(&matches[1], -1, -1);
+            setMatch(&matches[2], 1, 2);
+            setMatch(&matches[0], 0, 3);
+            return 8;
+        }
+    }
+    if (*expr == '"') {
+        for (ind = 1; expr[ind] && expr[ind] != '"'; ++ind) {
+            if (expr[ind] == '\\' && !expr[++ind])
+                break;
+        }
+        if (expr[ind] == '"') {
+            setMatch(&matches[0], 0, ind + 1);
+            return 9;
+        }
+    }
+    return 0;
+}
+
+/* pushes the chars of a string literal's body up to and including its
+ * closing quote. With closed the matcher has already found that quote and a
+ * line break is just another char; otherwise returns -1 when the line ends
+ * first, after pushing the line break as a char. Returns the bytes used. */
+static regoff_t
+lexString(char *expr, struct vector *tokens, int closed)
+{
+    regoff_t ind;
+    struct node node;
+    node_init(&node);
+    node.type = T_CHAR;
+    for (ind = 0; expr[ind] != '"'; ++ind) {
+        if (expr[ind] == '\\' && expr[ind + 1] != '\0'
+                && (closed || expr[ind + 1] != '\n')) {
+            node.data.c = expr[++ind];
+            escapeChar(&node.data.c);
+        } else if (!closed && (expr[ind] == '\\' || expr[ind] == '\0' || expr[ind] == '\n')) {
+            node.data.c = '\n';
+            vector_push(tokens, &node);
+            STATS_ADD(STATS_NODES, 1);
+            return -1;
+        } else {
+            node.data.c = expr[ind];
+        }
+        vector_push(tokens, &node);
+        STATS_ADD(STATS_NODES, 1);
+    }
+    node.type = T_VECTOR;
+    node.data.c = ']';
+    vector_push(tokens, &node);
+    STATS_ADD(STATS_NODES, 1);
+    return ind + 1;
+}
+
+/* lexes one line into a flat vector of tokens, with the regex matcher when
+ * regex is set; the caller owns tokens, even on error. With cont a string
+ * literal may run on over the end of the line: its newline becomes a char
+ * and cont->instring tells the next call to carry on inside the string. */
+int
+lex(char *expr, struct vector *tokens, int regex, struct readstate *cont)
+{
+    char *startchar, *endchar;
+    int state, base, sign, flag;
+    struct node node;
+    regmatch_t matches[5];
+    regoff_t suffix, used;
+    node_init(&node);
+    if (cont && cont->instring) {
+        used = lexString(expr, tokens, 0);
+        cont->instring = used < 0;
+        expr += used < 0 ? strlen(expr) : used;
+    }
     while (*expr != '\0' && *expr != '\n') {
-        /* state -> 0:error, -1:skip, 1: nil or bool, 2:float, 3:decimal,
-         *          4:binary, 5:octal, 6:hex, -> 7:expr, 8:char, 9:str */
-        state = 0;
-        if      (regexec(&regexSpace        , expr, 1, matches, 0) == 0) state = -1;
-        else if (regexec(&regexComment      , expr, 1, matches, 0) == 0) state = -1;
-        else if (regexec(&regexNilBool      , expr, 2, matches, 0) == 0) state = 1;
-        else if (regexec(&regexFloat        , expr, 4, matches, 0) == 0) state = 2;
-        else if (regexec(&regexDecimal      , expr, 5, matches, 0) == 0) state = 3;
-        else if (regexec(&regexBinary       , expr, 5, matches, 0) == 0) state = 4;
-        else if (regexec(&regexOctal        , expr, 5, matches, 0) == 0) state = 5;
-        else if (regexec(&regexHex          , expr, 5, matches, 0) == 0) state = 6;
-        else if (regexec(&regexSymbol       , expr, 1, matches, 0) == 0) state = 7;
-        else if (regexec(&regexSingleSymbol , expr, 1, matches, 0) == 0) state = 7;
-        else if (regexec(&regexSpecialSymbol, expr, 1, matches, 0) == 0) state = 7;
-        else if (regexec(&regexChar         , expr, 1, matches, 0) == 0) state = 8;
-        else if (regexec(&regexString       , expr, 1, matches, 0) == 0) state = 9;
-        else                                                               state = 0;
+        state = regex ? lexRegex(expr, matches, &suffix) : lexScan(expr, matches, &suffix);
+        if (!state && cont && *expr == '"') { /* string literal runs on */
+            node.type = T_VECTOR;
+            node.data.c = '[';
+            vector_push(tokens, &node);
+            STATS_ADD(STATS_NODES, 1);
+            lexString(expr + 1, tokens, 0);
+            cont->instring = 1;
+            break;
+        }
         if (!state) {
-            vector_free(&tree);
-            fprintf(stderr, "Fatal Error: Invalid state for rest of expression: “%s”", expr);
+            fprintf(stderr, "Fatal Error: Invalid state for rest of expression: “%s”\n", expr);
             return 1;
         }
-        if (state > 1 && state < 7) {
-            flag = regexec(&regexPostNumError, expr + matches[0].rm_eo, 1, errMatches, 0);
-            if (flag == 0 && errMatches[0].rm_eo) {
-                fprintf(stderr, "Fatal Error: Invalid suffix for number: \"%.*s\"\n",
-                        errMatches[0].rm_eo, expr);
-                return 2;
-            }
+        if (suffix) {
+            fprintf(stderr, "Fatal Error: Invalid suffix for number: \"%.*s\"\n",
+                    (int)(matches[0].rm_eo + suffix), expr);
+            return 2;
         }
         if (state > 0) {
             if (state == 1) {
@@ -307,7 +652,7 @@ tokenize(char *expr, struct vector *forest)
                     node.data.ld = s2ld(startchar, endchar) * sign;
                 } else {
                     node.type = T_DOUBLE;
-                    node.data.d = (double)s2ld(startchar, endchar);
+                    node.data.d = (double)s2ld(startchar, endchar) * sign;
                 }
             } else if (state < 7) {
                 sign = reduceSign(expr, matches[1].rm_eo);
@@ -316,8 +661,8 @@ tokenize(char *expr, struct vector *forest)
                 else
                     flag = 0; /* signed */
                 if (matches[1].rm_eo > matches[1].rm_so && flag)
-                    fprintf(stderr, "Warning: unsigned number has prefixed sign: \"%.*s\"",
-                            matches[0].rm_eo, expr);
+                    fprintf(stderr, "Warning: unsigned number has prefixed sign: \"%.*s\"\n",
+                            (int)matches[0].rm_eo, expr);
                 switch (state) {
                     case 3:  base = 10; break;
                     case 4:  base =  2; break;
@@ -333,7 +678,7 @@ tokenize(char *expr, struct vector *forest)
                         node.data.ul = (unsigned long)s2ull(startchar, endchar, base);
                     } else { /* signed */
                         node.type = T_LONG;
-                        node.data.l = (long)s2ull(startchar, endchar, base);
+                        node.data.l = (long)s2ull(startchar, endchar, base) * sign;
                     }
                 } else { /* int */
                     if (flag) { /* unsigned */
@@ -341,7 +686,7 @@ tokenize(char *expr, struct vector *forest)
                         node.data.ui = (unsigned int)s2ull(startchar, endchar, base);
                     } else { /* signed */
                         node.type = T_INT;
-                        node.data.i = (int)s2ull(startchar, endchar, base);
+                        node.data.i = (int)s2ull(startchar, endchar, base) * sign;
                     }
                 }
             } else if (state == 7) {
@@ -356,6 +701,11 @@ tokenize(char *expr, struct vector *forest)
                         node.type = T_VECTOR;
                         node.data.c = *expr;
                         break;
+                    case '{':
+                    case '}':
+                        node.type = T_MAP;
+                        node.data.c = *expr;
+                        break;
                     default:
                         node.type = T_EXPR;
                         node.data.s = malloc((matches[0].rm_eo + 1) * sizeof(char));
@@ -364,89 +714,353 @@ tokenize(char *expr, struct vector *forest)
                 }
             } else if (state == 8) {
                 node.type = T_CHAR;
-                node.data.c = *(expr + 1);
+                node.data.c = expr[matches[2].rm_so];
                 if (matches[1].rm_eo > matches[1].rm_so)
                     escapeChar(&node.data.c);
             } else if (state == 9) {
                 node.type = T_VECTOR;
                 node.data.c = '[';
-                vector_push(&tree, &node);
-                subexpr = expr + 1;
-                index = 1;
-                endindex = matches[0].rm_eo - 1;
-                flag = 0;
-                node.type = T_CHAR;
-                while (index++ < endindex) {
-                    if (!flag && *subexpr == '\\') {
-                        flag = 1;
-                    } else {
-                        node.data.c = *subexpr;
-                        if (flag) {
-                            escapeChar(&node.data.c);
-                            flag = 0;
-                        }
-                        vector_push(&tree, &node);
-                    }
-                }
-                node.type = T_VECTOR;
-                node.data.c = ']';
+                vector_push(tokens, &node);
+                STATS_ADD(STATS_NODES, 1);
+                lexString(expr + 1, tokens, 1);
+                expr += matches[0].rm_eo;
+                continue;
             }
-            vector_push(&tree, &node);
+            vector_push(tokens, &node);
+            STATS_ADD(STATS_NODES, 1);
         }
         expr += matches[0].rm_eo;
     }
-    furl(forest, &tree);
     return 0;
 }
 
 int
-furl(struct vector *forest, struct vector *tree)
+tokenize(char *expr, struct vector *forest)
+{
+    int err;
+    struct vector tree;
+    vector_init(&tree, sizeof(struct node));
+    err = lex(expr, &tree, 0, NULL);
+    if (err) {
+        freeTree(&tree);
+        return err;
+    }
+    STATS_START(STATS_FURL);
+    profile_push("furl");
+    err = furl(forest, &tree);
+    profile_pop();
+    STATS_STOP(STATS_FURL);
+    vector_free(&tree);
+    return err;
+}
+
+/* links one form in place: braces get the first inner node as child, the
+ * matching close brace is the last child and every node points to the next
+ * node at its depth as sibling. The form is never resized afterward so the
+ * pointers into its items stay valid. */
+static void
+linkForm(struct vector *form)
 {
-    struct node node, *nodeptr, parent;
-    struct vector parents, ftree;
-    vector_init(&parents, sizeof(struct node));
-    vector_init(&ftree, sizeof(struct node));
-    while (vector_size(tree)) {
-        vector_remove(tree, 0, &node);
-        vector_push(&ftree, &node);
-        nodeptr = (struct node*)vector_get(&free, 0);
-        if (node.type == T_LIST || node.type == T_VECTOR) {
+    size_t index, endindex;
+    struct node *node, *parent, **prev;
+    struct vector parents, prevs;
+    vector_init(&parents, sizeof(struct node *));
+    vector_init(&prevs, sizeof(struct node *));
+    parent = NULL;
+    vector_push(&prevs, &parent);
+    for (index = 0, endindex = vector_size(form); index < endindex; ++index) {
+        node = vector_get(form, index);
+        node->sibling = NULL;
+        node->child = NULL;
+        prev = vector_get(&prevs, vector_size(&prevs) - 1);
+        if (*prev)
+            (*prev)->sibling = node;
+        else if (vector_size(&parents))
+            (*(struct node **)vector_get(&parents, vector_size(&parents) - 1))->child = node;
+        *prev = node;
+        if (isOpenBrace(node)) {
             vector_push(&parents, &node);
+            parent = NULL;
+            vector_push(&prevs, &parent);
+        } else if (isCloseBrace(node)) {
+            vector_pop(&parents, NULL);
+            vector_pop(&prevs, NULL);
         }
     }
-    /* while (vector_size(tree)) { */
-    /*     vector_remove(vec, 0, &node); */
-    /*     /1* printNode(&node); *1/ */
-    /*     if (node.type == T_LIST || node.type == T_VECTOR) { */
-    /*             vector_push(&parents, &node); */
-    /*             node.child = node.sibling; */
-    /*             node.sibling = NULL; */
-    /*             node = *node.child; */
-    /*         } else { */
-    /*             if (!vector_size(&parents)) { */
-    /*                 fprintf(stderr, "Fatal Error: Unmatched closing '%c'.\n", node.data.c); */
-    /*                 vector_free(&parents); */
-    /*                 return 10; */
-    /*             } */
-    /*             vector_pop(&parents, &parent); */
-    /*             if (node.sibling && node.sibling->type && !vector_size(&parents)) { */
-    /*                 vector_push(forest, tree); */
-    /*                 tree_add_siblings(tree, node); */
-    /*             } */
-    /*             parent.sibling = *node.sibling; */
-    /*             node.sibling = NULL; */
-    /*             node = *parent.sibling; */
-    /*         } */
-    /*     } else { */
-    /*         node = node.sibling; */
-    /*     } */
-    /* } */
-    /* if (vector_size(&parents)) { */
-    /*     fputs("Fatal Error: Unmatched opening brace\n", stderr); */
-    /*     vector_free(&parents); */
-    /*     return 11; */
-    /* } */
     vector_free(&parents);
+    vector_free(&prevs);
+}
+
+static void freeData(struct vector *, size_t);
+
+struct brace {
+    char close;   /* expected closing brace */
+    size_t forms; /* forms read directly inside so far */
+};
+
+/* Brace-checks state's tokens from state->checked on, keeping the open-brace
+ * stack in state so a form may span many calls. Every finished top-level
+ * form is copied out, linked and pushed onto forest; *consumed is set to the
+ * number of leading tokens that were moved out that way. On error the symbol
+ * names of the unconsumed tokens are freed. */
+static int
+furlFrom(struct readstate *state, struct vector *forest, size_t *consumed)
+{
+    size_t index, endindex, start, err = 0;
+    struct node *node;
+    struct vector ftree;
+    struct brace brace, *outer;
+    start = *consumed = 0;
+    for (index = state->checked, endindex = vector_size(&state->tokens); index < endindex; ++index) {
+        node = vector_get(&state->tokens, index);
+        outer = vector_get(&state->braces, vector_size(&state->braces) - 1);
+        if (outer && !isCloseBrace(node))
+            ++outer->forms;
+        if (isOpenBrace(node)) {
+            brace.close = node->data.c == '(' ? ')' : node->data.c == '[' ? ']' : '}';
+            brace.forms = 0;
+            vector_push(&state->braces, &brace);
+        } else if (isCloseBrace(node)) {
+            if (!vector_size(&state->braces)) {
+                fprintf(stderr, "Fatal Error: Unmatched closing '%c'.\n", node->data.c);
+                err = 10;
+                break;
+            }
+            vector_pop(&state->braces, &brace);
+            if (brace.close != node->data.c) {
+                fprintf(stderr, "Fatal Error: Expected '%c' but found '%c'.\n",
+                        brace.close, node->data.c);
+                err = 12;
+                break;
+            }
+            if (brace.close == '}' && brace.forms % 2) {
+                fputs("Fatal Error: Map literal needs a value for every key\n", stderr);
+                err = 13;
+                break;
+            }
+        }
+        if (!vector_size(&state->braces)) { /* top-level form is complete */
+            vector_init(&ftree, sizeof(struct node));
+            for (; start <= index; ++start)
+                vector_push(&ftree, vector_get(&state->tokens, start));
+            linkForm(&ftree);
+            vector_push(forest, &ftree);
+        }
+    }
+    state->checked = endindex;
+    *consumed = start;
+    if (err)
+        freeData(&state->tokens, start);
+    return err;
+}
+
+int
+furl(struct vector *forest, struct vector *tree)
+{
+    struct readstate state;
+    size_t consumed;
+    int err;
+    readInit(&state);
+    vector_free(&state.tokens);
+    state.tokens = *tree; /* borrowed, the caller still frees tree */
+    err = furlFrom(&state, forest, &consumed);
+    if (!err && vector_size(&state.braces)) {
+        fputs("Fatal Error: Unmatched opening brace\n", stderr);
+        freeData(tree, consumed);
+        err = 11;
+    }
+    vector_free(&state.braces);
+    return err;
+}
+
+void
+readInit(struct readstate *state)
+{
+    vector_init(&state->tokens, sizeof(struct node));
+    vector_init(&state->braces, sizeof(struct brace));
+    state->checked = 0;
+    state->instring = 0;
+}
+
+/* drops an unfinished form, e.g. after an error in one of its lines */
+void
+readReset(struct readstate *state)
+{
+    freeData(&state->tokens, 0);
+    vector_clear(&state->tokens);
+    vector_clear(&state->braces);
+    state->checked = 0;
+    state->instring = 0;
+}
+
+/* Reads one more line of input. Only the new bytes are lexed and
+ * brace-checked; forms it finishes are pushed onto forest and a form left
+ * open waits in state for the next line. */
+int
+readLine(struct readstate *state, char *line, struct vector *forest)
+{
+    size_t consumed, index, endindex;
+    struct vector rest;
+    int err;
+    err = lex(line, &state->tokens, 0, state);
+    if (err) {
+        readReset(state);
+        return err;
+    }
+    STATS_START(STATS_FURL);
+    profile_push("furl");
+    err = furlFrom(state, forest, &consumed);
+    profile_pop();
+    STATS_STOP(STATS_FURL);
+    if (err) {
+        vector_clear(&state->tokens); /* names are moved out or freed */
+        readReset(state);
+        return err;
+    }
+    if (consumed) { /* keep only the tokens of the form still open */
+        vector_init(&rest, sizeof(struct node));
+        for (index = consumed, endindex = vector_size(&state->tokens); index < endindex; ++index)
+            vector_push(&rest, vector_get(&state->tokens, index));
+        vector_free(&state->tokens);
+        state->tokens = rest;
+        state->checked = vector_size(&rest);
+    }
+    return 0;
+}
+
+/* how many braces, string literals included, the next line continues */
+size_t
+readDepth(struct readstate *state)
+{
+    return vector_size(&state->braces);
+}
+
+void
+readFree(struct readstate *state)
+{
+    freeData(&state->tokens, 0);
+    vector_free(&state->tokens);
+    vector_free(&state->braces);
+}
+
+struct formseq {
+    struct reader *reader;
+    struct readstate state;
+    struct vector forest; /* forms read but not handed out yet */
+};
+
+static int
+formSeqStep(void *env, struct node *out, void **hold)
+{
+    struct formseq *forms = env;
+    struct vector *tree;
+    char *line;
+    while (!vector_size(&forms->forest)) {
+        line = reader_line(forms->reader);
+        if (!line) {
+            if (readDepth(&forms->state))
+                fputs("Fatal Error: Unmatched opening brace\n", stderr);
+            return 0;
+        }
+        if (readLine(&forms->state, line, &forms->forest))
+            fputs("Fatal Error during tokenization\n", stderr);
+    }
+    tree = malloc(sizeof(struct vector));
+    vector_remove(&forms->forest, 0, tree);
+    out->type = T_POINTER;
+    out->data.n = vector_get(tree, 0);
+    *hold = tree;
+    return 1;
+}
+
+static void
+formSeqRelease(void *tree)
+{
+    freeTree(tree);
+    free(tree);
+}
+
+static void
+formSeqDrop(void *env)
+{
+    struct formseq *forms = env;
+    dropForest(&forms->forest);
+    vector_free(&forms->forest);
+    readFree(&forms->state);
+    free(forms);
+}
+
+/* the forms of reader as a lazy sequence of T_POINTERs to their root nodes;
+ * each is read when the sequence gets to it and freed with its cell. Lines
+ * that fail to tokenize are reported and skipped. */
+struct seq*
+formSeq(struct reader *reader)
+{
+    struct formseq *forms = malloc(sizeof(struct formseq));
+    forms->reader = reader;
+    readInit(&forms->state);
+    vector_init(&forms->forest, sizeof(struct vector));
+    return seq_new(formSeqStep, formSeqRelease, formSeqDrop, forms);
+}
+
+/* makes out a T_HASHMAP holding the entries of a {k v ...} literal already
+ * linked by furl. Keys and values are copied by value, so compound ones still
+ * point into the literal's tree; the table belongs to the tree out is put in
+ * or, if none, to the caller (map_free, then free). */
+int
+mapLiteral(struct node *literal, struct node *out)
+{
+    struct node *key, *value;
+    struct map *map = malloc(sizeof(struct map));
+    map_init(map);
+    for (key = literal->child; key && !isCloseBrace(key); key = value->sibling) {
+        value = key->sibling;
+        if (!value || isCloseBrace(value) || !map_put(map, key, value)) {
+            map_free(map);
+            free(map);
+            return 1;
+        }
+    }
+    node_init(out);
+    out->type = T_HASHMAP;
+    out->data.m = map;
     return 0;
 }
 
+/* frees what tree's nodes from index start on own: symbol names, tables and
+ * one reference to each sequence */
+static void
+freeData(struct vector *tree, size_t start)
+{
+    size_t index, endindex;
+    struct node *node;
+    for (index = start, endindex = vector_size(tree); index < endindex; ++index) {
+        node = vector_get(tree, index);
+        if (node->type == T_EXPR) {
+            free(node->data.s);
+        } else if (node->type == T_HASHMAP) {
+            map_free(node->data.m);
+            free(node->data.m);
+        } else if (node->type == T_SEQ) {
+            seq_release(node->data.q);
+        }
+    }
+}
+
+void
+freeTree(struct vector *tree)
+{
+    freeData(tree, 0);
+    vector_free(tree);
+}
+
+/* frees every tree of forest and leaves it empty */
+void
+dropForest(struct vector *forest)
+{
+    struct vector tree;
+    while (vector_size(forest)) {
+        vector_pop(forest, &tree);
+        freeTree(&tree);
+    }
+}
@@ -0,0 +1,41 @@
+
+#ifndef LISP_H
+#define LISP_H
+
+#include <stdlib.h>
+
+#include "node.h"
+#include "vector.h"
+#include "map.h"
+#include "reader.h"
+#include "seq.h"
+
+/* reader state kept between lines while a form spans several of them */
+struct readstate {
+    struct vector tokens; /* lexed tokens of the form still open */
+    struct vector braces; /* open braces, innermost last */
+    size_t checked;       /* tokens already brace-checked */
+    int instring;         /* the last line ended inside a string literal */
+};
+
+int READ(char prompt[], struct reader *, struct readstate *, struct vector *);
+struct node* EVAL(struct vector *);
+void PRINT(struct vector *);
+void printNode(struct node *);
+int tokenize(char *, struct vector *);
+int lex(char *, struct vector *, int, struct readstate *);
+int furl(struct vector *, struct vector *);
+void freeTree(struct vector *);
+void dropForest(struct vector *);
+int mapLiteral(struct node *, struct node *);
+
+void readInit(struct readstate *);
+int readLine(struct readstate *, char *, struct vector *);
+size_t readDepth(struct readstate *);
+void readReset(struct readstate *);
+void readFree(struct readstate *);
+
+struct seq* formSeq(struct reader *);
+
+#endif
+
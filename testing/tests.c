@@ -2,9 +2,17 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "vector.h"
 #include "node.h"
+#include "map.h"
+#include "reader.h"
+#include "profile.h"
+#include "../lisp.h"
 
 void
 test_vector()
@@ -108,10 +116,476 @@ test_node()
     assert(node_get_data(node_get_sibling(&node)).c == 's');
 }
 
+void
+test_reader()
+{
+    int fds[2];
+    size_t ind;
+    char *line, longline[3 * READER_INIT_CAPACITY];
+    struct reader r;
+
+    memset(longline, 'x', sizeof(longline) - 1);
+    longline[sizeof(longline) - 1] = '\0';
+
+    assert(pipe(fds) == 0);
+    reader_init(&r, fds[0]);
+    if (fork() == 0) {
+        close(fds[0]);
+        assert(write(fds[1], "(a b)\n\n", 7) == 7);
+        assert(write(fds[1], longline, strlen(longline)) == strlen(longline));
+        assert(write(fds[1], "\nlast", 5) == 5);
+        _exit(0);
+    }
+    close(fds[1]);
+
+    line = reader_line(&r);
+    assert(line && strcmp(line, "(a b)") == 0);
+    line = reader_line(&r);
+    assert(line && strcmp(line, "") == 0);
+    line = reader_line(&r);
+    assert(line && strlen(line) == strlen(longline));
+    for (ind = 0; line[ind]; ++ind)
+        assert(line[ind] == 'x');
+    line = reader_line(&r);
+    assert(line && strcmp(line, "last") == 0);
+    assert(reader_line(&r) == NULL);
+    assert(reader_line(&r) == NULL);
+
+    close(fds[0]);
+    reader_free(&r);
+}
+
+void
+test_profile()
+{
+    char path[] = "/tmp/clisp-profile-XXXXXX", line[64];
+    int found = 0;
+    clock_t end;
+    FILE *in;
+
+    close(mkstemp(path));
+    assert(profile_start(path) == 0);
+    profile_push("outer");
+    profile_push("inner");
+    for (end = clock() + CLOCKS_PER_SEC / 5; clock() < end;)
+        ;
+    profile_pop();
+    profile_pop();
+    profile_pop(); /* unbalanced pops are ignored */
+    assert(profile_stop() == 0);
+
+    in = fopen(path, "r");
+    assert(in);
+    while (fgets(line, sizeof(line), in))
+        if (strncmp(line, "outer;inner ", 12) == 0)
+            ++found;
+    assert(found == 1); /* every sample of the stack lands on one line */
+    fclose(in);
+    unlink(path);
+}
+
+static int
+lex_both(char *input)
+{
+    int same;
+    size_t ind, size;
+    struct vector scanned, matched;
+
+    vector_init(&scanned, sizeof(struct node));
+    vector_init(&matched, sizeof(struct node));
+    same = lex(input, &scanned, 0, NULL) == lex(input, &matched, 1, NULL);
+    size = vector_size(&scanned);
+    same = same && size == vector_size(&matched);
+    for (ind = 0; same && ind < size; ++ind)
+        same = node_equal(vector_get(&scanned, ind), vector_get(&matched, ind));
+    freeTree(&scanned);
+    freeTree(&matched);
+    return same;
+}
+
+/* the hand-written lexer must agree with the regex lexer token for token */
+void
+test_lexer()
+{
+    static const char *pieces[] = {
+        "(", ")", "[", "]", " ", "\t", "\n", ";", "+", "-", ".", "0", "1", "7", "9",
+        "a", "f", "x", "b", "o", "B", "X", "u", "l", "d", "_", "!", "@", "#", "'",
+        "\"", "\\", "<", "=", "|", "~", "$", "{", "}", ",", "\x80",
+        "nil", "true", "false", "0x", "0b", "0o", "'\\n'", "'\\''", "\"a\\\"b\"",
+    };
+    char input[128];
+    size_t ind, len, count = sizeof(pieces) / sizeof(*pieces);
+    unsigned long state = 2463534242ul;
+    int saved, devnull, round;
+    struct vector forest, tree;
+
+    assert(lex_both("(1 -5 --3 0x1f 0b101 017 0o17 -1.5 .5d \"a\\tb\" '\\n' nil (+ a))"));
+
+    vector_init(&forest, sizeof(struct vector));
+    assert(tokenize("(-5 0x1f \"ab\" '\\'')", &forest) == 0);
+    vector_pop(&forest, &tree);
+    assert(vector_size(&tree) == 9);
+    assert(((struct node *)vector_get(&tree, 1))->data.i == -5);
+    assert(((struct node *)vector_get(&tree, 2))->data.i == 31);
+    assert(((struct node *)vector_get(&tree, 4))->data.c == 'a');
+    assert(((struct node *)vector_get(&tree, 5))->data.c == 'b');
+    assert(((struct node *)vector_get(&tree, 7))->data.c == '\'');
+    freeTree(&tree);
+
+    /* a line break inside a string matched whole is just a char */
+    assert(lex_both("(x \"a\nb\" \"c\\\nd\" y)"));
+    assert(tokenize("(x \"a\nb\" \"c\\\nd\" y)", &forest) == 0);
+    vector_pop(&forest, &tree);
+    assert(vector_size(&tree) == 14);
+    assert(((struct node *)vector_get(&tree, 4))->data.c == '\n');
+    assert(((struct node *)vector_get(&tree, 6))->data.c == ']');
+    assert(((struct node *)vector_get(&tree, 9))->data.c == '\n');
+    freeTree(&tree);
+
+    /* keywords only stand alone, symbols may start with them */
+    assert(lex_both("(nilable true_fn falsey nil' false! true)"));
+    assert(tokenize("(nilable true_fn falsey nil)", &forest) == 0);
+    vector_pop(&forest, &tree);
+    assert(vector_size(&tree) == 6);
+    assert(strcmp(((struct node *)vector_get(&tree, 1))->data.s, "nilable") == 0);
+    assert(strcmp(((struct node *)vector_get(&tree, 2))->data.s, "true_fn") == 0);
+    assert(strcmp(((struct node *)vector_get(&tree, 3))->data.s, "falsey") == 0);
+    assert(((struct node *)vector_get(&tree, 4))->type == T_NIL);
+    freeTree(&tree);
+    vector_free(&forest);
+
+    /* lexer errors are expected below; keep them off the terminal */
+    fflush(stderr);
+    saved = dup(2);
+    devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, 2);
+    for (round = 0; round < 20000; ++round) {
+        for (len = 0; ; len += strlen(pieces[ind])) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ind = state % count;
+            if (len + strlen(pieces[ind]) >= sizeof(input) || state % 23 == 0)
+                break;
+            strcpy(input + len, pieces[ind]);
+        }
+        input[len] = '\0';
+        if (!lex_both(input)) {
+            dup2(saved, 2);
+            fprintf(stderr, "lexers disagree on “%s”\n", input);
+            assert(0);
+        }
+    }
+    dup2(saved, 2);
+    close(saved);
+    close(devnull);
+}
+
+/* what printNode writes for node, up to size - 1 bytes */
+static void
+print_node(struct node *node, char *line, size_t size)
+{
+    int saved;
+    FILE *out = tmpfile();
+    fflush(stdout);
+    saved = dup(STDOUT_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+    printNode(node);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    rewind(out);
+    if (!fgets(line, size, out))
+        *line = '\0';
+    fclose(out);
+}
+
+void
+test_map()
+{
+    long ind;
+    struct map m;
+    struct node key, value, *found;
+    char line[64];
+    struct node table, same, less;
+    struct vector forest, literal, keys, other, small;
+
+    map_init(&m);
+    node_init(&key);
+    node_init(&value);
+
+    for (ind = 0; ind < 10000; ++ind) {
+        node_set(&key, T_LONG, (union node_data){ .l = ind });
+        node_set(&value, T_LONG, (union node_data){ .l = ind * 2 });
+        assert(map_put(&m, &key, &value));
+    }
+    assert(map_size(&m) == 10000);
+
+    for (ind = 0; ind < 10000; ind += 2) {
+        node_set(&key, T_LONG, (union node_data){ .l = ind });
+        assert(map_remove(&m, &key, &value));
+        assert(value.data.l == ind * 2);
+        assert(!map_remove(&m, &key, NULL));
+    }
+    assert(map_size(&m) == 5000);
+
+    for (ind = 0; ind < 10000; ++ind) {
+        node_set(&key, T_LONG, (union node_data){ .l = ind });
+        found = map_get(&m, &key);
+        if (ind % 2)
+            assert(found && found->data.l == ind * 2);
+        else
+            assert(!found);
+    }
+
+    /* same value, different type: different key */
+    node_set(&key, T_INT, (union node_data){ .i = 1 });
+    assert(!map_get(&m, &key));
+    node_set(&value, T_LONG, (union node_data){ .l = -1 });
+    assert(map_put(&m, &key, &value));
+    node_set(&key, T_LONG, (union node_data){ .l = 1 });
+    assert(map_get(&m, &key)->data.l == 2);
+    assert(map_size(&m) == 5001);
+
+    map_clear(&m);
+    assert(map_size(&m) == 0);
+    assert(!map_get(&m, &key));
+    map_free(&m);
+
+    /* literal keys of every kind, looked up by separately read nodes */
+    vector_init(&forest, sizeof(struct vector));
+    assert(tokenize("{a 1 \"ab\" 2 1.5 3 'c' 4 -7 5 (x [y]) 6 a 7}", &forest) == 0);
+    assert(tokenize("[a \"ab\" 1.5 'c' -7 (x [y]) \"abc\" b]", &forest) == 0);
+    vector_remove(&forest, 0, &literal);
+    vector_remove(&forest, 0, &keys);
+    assert(mapLiteral(vector_get(&literal, 0), &table) == 0);
+    assert(table.type == T_HASHMAP);
+    assert(map_size(table.data.m) == 6); /* the second a replaces the first */
+    for (ind = 0, found = ((struct node *)vector_get(&keys, 0))->child;
+            ind < 6; ++ind, found = found->sibling)
+        assert(map_get(table.data.m, found)->data.i == (ind ? ind + 1 : 7));
+    assert(!map_get(table.data.m, found));
+    assert(!map_get(table.data.m, found->sibling));
+
+    /* tables hash and compare by their entries, not by their order */
+    assert(tokenize("{(x [y]) 6 1.5 3 \"ab\" 2 'c' 4 a 7 -7 5}", &forest) == 0);
+    assert(tokenize("{a 7 \"ab\" 2}", &forest) == 0);
+    vector_remove(&forest, 0, &other);
+    vector_remove(&forest, 0, &small);
+    assert(mapLiteral(vector_get(&other, 0), &same) == 0);
+    assert(mapLiteral(vector_get(&small, 0), &less) == 0);
+    assert(node_equal(&table, &same) && node_hash(&table) == node_hash(&same));
+    assert(!node_equal(&table, &less) && !node_equal(&less, &table));
+
+    /* printed as a literal in table order, compound keys in full */
+    print_node(&less, line, sizeof(line));
+    assert(strcmp(line, "{#<a expression> 7 ['a' 'b'] 2}") == 0
+            || strcmp(line, "{['a' 'b'] 2 #<a expression> 7}") == 0);
+
+    for (ind = 0; ind < 3; ++ind) {
+        found = ind == 0 ? &table : ind == 1 ? &same : &less;
+        map_free(found->data.m);
+        free(found->data.m);
+    }
+    freeTree(&other);
+    freeTree(&small);
+    freeTree(&literal);
+    freeTree(&keys);
+    vector_free(&forest);
+}
+
+/* a form spread over several lines reads like the same form on one line */
+void
+test_readline()
+{
+    char lines[][16] = { "(a [1", "2 3]", "", "  {k \"v", "w\"} 4)", "(b) (c", ")" };
+    char joined[] = "(a [1 2 3] {k \"v\\nw\"} 4) (b) (c )";
+    size_t depths[] = { 2, 1, 1, 3, 0, 1, 0 }, forms[] = { 0, 0, 0, 0, 1, 2, 3 };
+    size_t ind, tok;
+    int saved, devnull;
+    struct readstate state;
+    struct vector forest, expected, tree, other;
+
+    readInit(&state);
+    vector_init(&forest, sizeof(struct vector));
+    for (ind = 0; ind < sizeof(lines) / sizeof(*lines); ++ind) {
+        assert(readLine(&state, lines[ind], &forest) == 0);
+        assert(readDepth(&state) == depths[ind]);
+        assert(vector_size(&forest) == forms[ind]);
+        assert(state.instring == (ind == 3));
+    }
+
+    vector_init(&expected, sizeof(struct vector));
+    assert(tokenize(joined, &expected) == 0);
+    assert(vector_size(&expected) == 3);
+    while (vector_size(&forest)) {
+        vector_remove(&forest, 0, &tree);
+        vector_remove(&expected, 0, &other);
+        assert(vector_size(&tree) == vector_size(&other));
+        for (tok = 0; tok < vector_size(&tree); ++tok)
+            assert(node_equal(vector_get(&tree, tok), vector_get(&other, tok)));
+        freeTree(&tree);
+        freeTree(&other);
+    }
+
+    /* an error drops the open form and the next line starts afresh */
+    saved = dup(STDERR_FILENO);
+    devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDERR_FILENO);
+    assert(readLine(&state, "(x (y", &forest) == 0);
+    assert(readLine(&state, "z]", &forest) == 12);
+    dup2(saved, STDERR_FILENO);
+    close(devnull);
+    close(saved);
+    assert(readDepth(&state) == 0 && vector_size(&forest) == 0);
+    assert(readLine(&state, "(ok)", &forest) == 0 && vector_size(&forest) == 1);
+    vector_remove(&forest, 0, &tree);
+    freeTree(&tree);
+
+    vector_free(&forest);
+    vector_free(&expected);
+    readFree(&state);
+}
+
+/* counts up from 0 forever and tracks how often it was stepped */
+struct counter {
+    long next;
+    size_t steps, dropped;
+};
+
+static int
+count_step(void *env, struct node *out, void **hold)
+{
+    struct counter *counter = env;
+    ++counter->steps;
+    node_set(out, T_LONG, (union node_data){ .l = counter->next++ });
+    return 1;
+}
+
+static void
+count_drop(void *env)
+{
+    ++((struct counter *)env)->dropped;
+}
+
+static void
+square(struct node *in, struct node *out, void *ctx)
+{
+    node_set(out, T_LONG, (union node_data){ .l = in->data.l * in->data.l });
+}
+
+static int
+odd(struct node *item, void *ctx)
+{
+    return item->data.l % 2;
+}
+
+static void
+sum(struct node *acc, struct node *item, void *ctx)
+{
+    acc->data.l += item->type == T_POINTER ? item->data.n->child->sibling->data.i : item->data.l;
+}
+
+void
+test_seq()
+{
+    int fds[2];
+    struct counter counter = { 0, 0, 0 };
+    char line[64];
+    struct seq *seq, *head;
+    struct node acc, table;
+    struct vector forest, literal, other;
+    struct reader r;
+
+    /* cells are realized once, on demand, and memoized */
+    seq = seq_new(count_step, NULL, count_drop, &counter);
+    assert(counter.steps == 0);
+    assert(seq_first(seq)->data.l == 0 && seq_first(seq)->data.l == 0);
+    assert(counter.steps == 1);
+    head = seq_retain(seq);
+    seq = seq_next(seq);
+    seq = seq_next(seq);
+    assert(seq_first(seq)->data.l == 2 && counter.steps == 3);
+    assert(seq_first(head)->data.l == 0); /* still there while held */
+    seq_release(head);
+    seq_release(seq);
+    assert(counter.dropped == 1);
+
+    /* sum of the first 1000 odd squares of an endless sequence */
+    counter = (struct counter){ 0, 0, 0 };
+    seq = seq_new(count_step, NULL, count_drop, &counter);
+    seq = seq_take(seq_filter(seq_map(seq, square, NULL), odd, NULL), 1000);
+    node_set(&acc, T_LONG, (union node_data){ .l = 0 });
+    assert(seq_reduce(seq, sum, &acc, NULL) == 1000);
+    assert(acc.data.l == 1333333000); /* 1^2 + 3^2 + ... + 1999^2 */
+    assert(counter.steps == 2000 && counter.dropped == 1);
+
+    /* lines and forms straight off the chunked reader */
+    assert(pipe(fds) == 0);
+    if (fork() == 0) {
+        close(fds[0]);
+        assert(write(fds[1], "(a 1) (b 2)\n(c\n 3)\n(d 4)", 24) == 24);
+        _exit(0);
+    }
+    close(fds[1]);
+    reader_init(&r, fds[0]);
+    seq = seq_lines(&r);
+    assert(seq_first(seq)->type == T_STRING);
+    assert(strcmp(seq_first(seq)->data.s, "(a 1) (b 2)") == 0);
+    print_node(seq_first(seq), line, sizeof(line));
+    assert(strcmp(line, "['(' 'a' ' ' '1' ')' ' ' '(' 'b' ' ' '2' ')']") == 0);
+    node_set(&table, T_STRING, (union node_data){ .s = "q\"\\\t" });
+    print_node(&table, line, sizeof(line));
+    assert(strcmp(line, "['q' '\"' '\\\\' '\\t']") == 0); /* reads back */
+
+    /* a line is the same key as the string literal with its text */
+    vector_init(&forest, sizeof(struct vector));
+    assert(tokenize("{\"(a 1) (b 2)\" 9} \"(a 1)\"", &forest) == 0);
+    vector_remove(&forest, 0, &literal);
+    vector_remove(&forest, 0, &other);
+    assert(mapLiteral(vector_get(&literal, 0), &table) == 0);
+    assert(map_get(table.data.m, seq_first(seq))->data.i == 9);
+    assert(node_equal(seq_first(seq), vector_get(&literal, 1)));
+    assert(node_equal(vector_get(&literal, 1), seq_first(seq)));
+    assert(node_hash(seq_first(seq)) == node_hash(vector_get(&literal, 1)));
+    assert(!node_equal(seq_first(seq), vector_get(&other, 0)));
+    map_free(table.data.m);
+    free(table.data.m);
+    freeTree(&literal);
+    freeTree(&other);
+    seq_release(seq); /* its next cell is never realized */
+
+    /* forms print in full through their T_POINTER elements */
+    seq = formSeq(&r);
+    print_node(seq_first(seq), line, sizeof(line));
+    assert(strcmp(line, "(#<c expression> 3)") == 0);
+    node_set(&acc, T_LONG, (union node_data){ .l = 0 });
+    assert(seq_reduce(seq, sum, &acc, NULL) == 2);
+    assert(acc.data.l == 7);
+
+    /* a tree owns the sequences its T_SEQ nodes hold */
+    counter = (struct counter){ 0, 0, 0 };
+    seq = seq_new(count_step, NULL, count_drop, &counter);
+    node_set(&table, T_SEQ, (union node_data){ .q = seq });
+    vector_init(&literal, sizeof(struct node));
+    vector_push(&literal, &table);
+    freeTree(&literal);
+    assert(counter.dropped == 1);
+    vector_free(&forest);
+    close(fds[0]);
+    reader_free(&r);
+}
+
 int
 main(void)
 {
     test_vector();
     test_node();
+    test_reader();
+    test_profile();
+    test_lexer();
+    test_readline();
+    test_seq();
+    test_map();
     puts("all tests passed :)");
 }